@@ -0,0 +1,19 @@
+// include/bench.h
+#ifndef __BENCH_H__
+#define __BENCH_H__
+
+// kernel/bench.c：作为进程运行的微基准测试（make bench）
+int bench_suite(const char *rev);
+void bench_all(void);
+void bench_vdso(void);
+void bench_printf(void);
+void bench_string(void);
+void bench_dirlookup(void);
+void bench_namei(void);
+void bench_blk(void);
+void bench_journal(void);
+void bench_readahead(void);
+void bench_sendfile(void);
+void bench_pipe(void);
+
+#endif
@@ -0,0 +1,119 @@
+// include/blk/blk.h
+#ifndef __BLK_H__
+#define __BLK_H__
+
+#include "riscv.h"
+
+// 块大小等于页大小：缓存页直接作为 DMA 缓冲区
+#define BSIZE        PGSIZE
+#define SECTOR_SIZE  512
+#define NBUF         256     // 页缓存容量（块数）
+#define BUF_HASH     64
+
+// 页缓存中的一个块
+struct buf {
+    int valid;       // data 已从设备读入
+    int dirty;       // 已修改，尚未写回
+    int busy;        // 被某个进程持有（bread 到 brelse 之间）
+    int io;          // I/O 进行中，完成时清零
+    int flushing;    // 正在被 bsync 写回
+    int pinned;      // 在未提交的日志事务中，提交前不能写回原位置或被淘汰
+    int readahead;   // 预读 I/O 进行中，完成时由中断释放
+    int prefetched;  // 由预读读入，尚未被访问
+    uint blockno;
+    int refcnt;
+    char *data;      // 一页，首次使用时分配
+    struct buf *hnext;
+    struct buf *prev;  // LRU，表头是最近使用的
+    struct buf *next;
+};
+
+// 块层请求：一段连续的块，每块一个 buf（设备侧是一个多段 DMA 请求）
+#define BLK_MAX_SEGS 32      // 单个请求最多合并 32 块（128KB）
+#define NREQ         64
+
+struct blk_request {
+    int write;
+    uint start;                      // 起始块号
+    int nbufs;
+    struct buf *bufs[BLK_MAX_SEGS];  // 按块号递增
+    uint64_t t_queue;                // 入队时间（rdtime）
+    struct blk_request *next;        // 等待队列，按 start 排序
+};
+
+// 块设备驱动
+// queue_rq 把请求放入设备队列（不通知设备），没有空间时返回 -1
+// kick 通知设备处理已放入的请求；完成后驱动调用 blk_complete
+// poll 在没有进程可切换（启动阶段）时代替中断回收完成的请求
+struct blkdev {
+    const char *name;
+    uint64_t nblocks;
+    int (*queue_rq)(struct blk_request *rq);
+    void (*kick)(void);
+    void (*poll)(void);
+};
+
+extern struct blkdev *blkdev;
+
+// kernel/blk/blkq.c：合并、电梯排序、批量派发
+void blk_submit(struct buf **bufs, int n, int write);
+void blk_wait(struct buf *b);
+void blk_rw(struct buf **bufs, int n, int write);
+void blk_plug(void);
+void blk_unplug(void);
+void blk_dispatch(void);
+void blk_complete(struct blk_request *rq, int ok);
+void blk_stats_dump(void);
+
+struct blk_stats {
+    uint64_t bios;          // 提交的块数
+    uint64_t merges;        // 并入已有请求的块数
+    uint64_t requests;      // 派发给设备的请求数
+    uint64_t kicks;         // 通知设备的次数
+    uint64_t errors;
+    uint64_t lat_total;     // 请求延迟（入队到完成，rdtime 计数）
+    uint64_t lat_max;
+    uint64_t depth_sum;     // 每次派发时设备中的请求数之和
+    int depth_max;
+    int lat_hist[16];       // 延迟直方图：第 i 格为 [2^i, 2^(i+1)) 微秒，第 0 格从 0 开始
+};
+extern struct blk_stats blk_stats;
+
+// kernel/blk/virtio_blk.c
+int virtio_blk_init(void);
+void virtio_blk_intr(void);
+extern int virtio_blk_irq;
+
+// kernel/blk/ramdisk.c
+void ramdisk_init(void);
+
+// kernel/blk/pcache.c
+void blk_init(void);
+struct buf* bread(uint blockno);
+struct buf* bget_zero(uint blockno);
+void bwrite(struct buf *b);
+void brelse(struct buf *b);
+void bpin(struct buf *b);
+void bunpin(struct buf *b);
+void bsync(void);
+void breadahead(uint *blocks, int n);
+void breadahead_done(struct buf *b, int ok);
+void pcache_tick(void);
+void bflush_task(void);
+
+// 回写线程：脏块达到 DIRTY_HIGH 或每隔 FLUSH_TICKS 个时钟中断批量写回
+#define DIRTY_HIGH   (NBUF / 4)
+#define FLUSH_TICKS  10
+
+struct pcache_stats {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t writebacks;   // 写回设备的块数
+    uint64_t ra_blocks;    // 预读提交的块数
+    uint64_t ra_hits;      // 预读的块后来被读到
+    uint64_t flushes;      // 回写线程的批次数
+    uint64_t flush_blocks; // 回写线程写回的块数
+};
+extern struct pcache_stats pcache_stats;
+
+#endif
@@ -0,0 +1,84 @@
+// include/blk/virtio.h
+// virtio MMIO（version 2）寄存器与 virtqueue 结构，见 virtio 1.1 规范 4.2 / 2.6
+#ifndef __VIRTIO_H__
+#define __VIRTIO_H__
+
+#include "riscv.h"
+
+#define VIRTIO_MMIO_MAGIC_VALUE       0x000   // 0x74726976 ("virt")
+#define VIRTIO_MMIO_VERSION           0x004
+#define VIRTIO_MMIO_DEVICE_ID         0x008   // 2 = 块设备
+#define VIRTIO_MMIO_VENDOR_ID         0x00c
+#define VIRTIO_MMIO_DEVICE_FEATURES   0x010
+#define VIRTIO_MMIO_DRIVER_FEATURES   0x020
+#define VIRTIO_MMIO_QUEUE_SEL         0x030
+#define VIRTIO_MMIO_QUEUE_NUM_MAX     0x034
+#define VIRTIO_MMIO_QUEUE_NUM         0x038
+#define VIRTIO_MMIO_QUEUE_READY       0x044
+#define VIRTIO_MMIO_QUEUE_NOTIFY      0x050
+#define VIRTIO_MMIO_INTERRUPT_STATUS  0x060
+#define VIRTIO_MMIO_INTERRUPT_ACK     0x064
+#define VIRTIO_MMIO_STATUS            0x070
+#define VIRTIO_MMIO_QUEUE_DESC_LOW    0x080
+#define VIRTIO_MMIO_QUEUE_DESC_HIGH   0x084
+#define VIRTIO_MMIO_DRIVER_DESC_LOW   0x090   // avail 环
+#define VIRTIO_MMIO_DRIVER_DESC_HIGH  0x094
+#define VIRTIO_MMIO_DEVICE_DESC_LOW   0x0a0   // used 环
+#define VIRTIO_MMIO_DEVICE_DESC_HIGH  0x0a4
+#define VIRTIO_MMIO_CONFIG            0x100   // 块设备：uint64 容量（扇区）
+
+// 设备状态位
+#define VIRTIO_STATUS_ACKNOWLEDGE  1
+#define VIRTIO_STATUS_DRIVER       2
+#define VIRTIO_STATUS_DRIVER_OK    4
+#define VIRTIO_STATUS_FEATURES_OK  8
+
+// 特性位：只关闭我们不处理的
+#define VIRTIO_BLK_F_RO            5
+#define VIRTIO_BLK_F_SCSI          7
+#define VIRTIO_BLK_F_CONFIG_WCE    11
+#define VIRTIO_BLK_F_MQ            12
+#define VIRTIO_F_ANY_LAYOUT        27
+#define VIRTIO_RING_F_INDIRECT_DESC 28
+#define VIRTIO_RING_F_EVENT_IDX    29
+
+// 描述符数（每个请求占 nbufs + 2 个：请求头、数据段、状态）
+#define VIRTIO_NUM 128
+
+struct virtq_desc {
+    uint64_t addr;
+    uint32_t len;
+    uint16_t flags;
+    uint16_t next;
+};
+#define VRING_DESC_F_NEXT  1
+#define VRING_DESC_F_WRITE 2   // 设备写入（对应读请求的数据）
+
+struct virtq_avail {
+    uint16_t flags;
+    uint16_t idx;
+    uint16_t ring[VIRTIO_NUM];
+    uint16_t unused;
+};
+
+struct virtq_used_elem {
+    uint32_t id;    // 请求链首描述符
+    uint32_t len;
+};
+
+struct virtq_used {
+    uint16_t flags;
+    uint16_t idx;
+    struct virtq_used_elem ring[VIRTIO_NUM];
+};
+
+// 块设备请求头
+#define VIRTIO_BLK_T_IN   0   // 读
+#define VIRTIO_BLK_T_OUT  1   // 写
+struct virtio_blk_req {
+    uint32_t type;
+    uint32_t reserved;
+    uint64_t sector;
+};
+
+#endif
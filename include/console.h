@@ -2,8 +2,15 @@
 #ifndef __CONSOLE_H__
 #define __CONSOLE_H__
 
+#include "riscv.h"
+
+void console_write(const char *s, int n);
 void console_putc(char c);
 void console_puts(const char *s);
+void console_drain(void);
+void console_flush(void);
+void console_panic(void);
+uint64_t console_dropped(void);
 
 // ✅ 添加以下声明！
 void clear_screen(void);
@@ -0,0 +1,12 @@
+// include/cpu.h
+#ifndef __CPU_H__
+#define __CPU_H__
+
+// 启动时探测 hart 的可选扩展（V、Zicboz），据此选择 string.c 的实现
+// 探测期间 kerneltrap 把非法指令异常记入 cpu_probing 并跳过该指令
+extern volatile int cpu_probing;   // 1：探测中；2：探测的指令是非法指令
+extern int cpu_mmode;              // 内核运行在 M 模式（-bios none），没有 SBI 可调用
+
+void cpu_probe(void);
+
+#endif
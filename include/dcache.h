@@ -0,0 +1,27 @@
+// include/dcache.h
+#ifndef __DCACHE_H__
+#define __DCACHE_H__
+
+#include "riscv.h"
+
+// 路径查找缓存：(父目录 inum, 名字) -> inum，inum 为 0 表示“不存在”（负缓存）
+#define NDCACHE   256
+#define DC_HASH   128
+
+struct dcache_stats {
+    uint64_t hits;       // 命中且存在
+    uint64_t neg_hits;   // 命中负缓存
+    uint64_t misses;
+    uint64_t evictions;
+};
+
+extern struct dcache_stats dcache_stats;
+
+void dcache_init(void);
+int dcache_lookup(uint parent, const char *name, uint hash, uint *inum);
+void dcache_insert(uint parent, const char *name, uint hash, uint inum);
+void dcache_invalidate(uint parent, const char *name, uint hash);
+void dcache_purge(uint inum);
+void dcache_dump(void);
+
+#endif
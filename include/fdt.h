@@ -0,0 +1,45 @@
+// include/fdt.h
+#ifndef __FDT_H__
+#define __FDT_H__
+
+#include "riscv.h"
+
+// 从 QEMU 在 a1 中传入的扁平设备树（FDT）得到的机器描述
+// 没有可用的 DTB 时保持 riscv.h 中 QEMU virt 的默认值（128MB 内存、单 hart）
+#define NMEMRANGE  4
+#define NRESERVED  4
+
+struct memrange {
+    uint64_t base;
+    uint64_t size;
+};
+
+struct machine {
+    int from_fdt;                         // 0：以下都是默认值
+    int nmem;
+    struct memrange mem[NMEMRANGE];       // 物理内存
+    int nresv;
+    struct memrange resv[NRESERVED];      // 不能分配的内存：DTB 本身与 /memreserve/
+    int nharts;
+    uint64_t uart;
+    int uart_irq;
+    uint64_t plic;
+    int plic_ndev;
+    uint64_t finisher;                    // sifive,test0/1，0 表示没有
+    int nvirtio;
+    struct {
+        uint64_t base;
+        int irq;
+    } virtio[VIRTIO_SLOTS];               // 按地址升序
+    char bootargs[128];                   // /chosen/bootargs
+};
+
+extern struct machine machine;
+
+void fdt_init(uint64_t dtb);
+void fdt_dump(void);
+uint64_t machine_ram_end(void);
+int machine_bootarg(const char *name, int *val);
+void machine_exit(int code) __attribute__((noreturn));
+
+#endif
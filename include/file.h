@@ -0,0 +1,54 @@
+// include/file.h
+#ifndef __FILE_H__
+#define __FILE_H__
+
+#include "riscv.h"
+
+#define NFILE       64                             // 系统范围的打开文件对象数
+#define NFD_INLINE  8                              // fd 表内嵌的槽位
+#define NOFILE      (PGSIZE / sizeof(struct file*))  // 每个进程最多 512 个 fd
+#define FDMAP_WORDS (NOFILE / 64)
+#define RA_MIN_PAGES 4                             // 检测到顺序读后的初始预读窗口
+#define RA_MAX_PAGES 32                            // 窗口上限（一个 128KB 的块层请求）
+
+// 打开文件对象：dup 出的 fd 与共享 fd 表的线程指向同一个对象，共享偏移
+struct file {
+    enum { FD_NONE, FD_INODE, FD_CONSOLE, FD_PIPE } type;
+    int ref;            // 引用计数
+    struct inode *ip;   // FD_INODE 时指向 inode
+    struct pipe *pipe;  // FD_PIPE 时指向管道
+    char readable;      // 管道的读端/写端
+    char writable;
+    uint off;           // 读写偏移
+    uint ra_pos;        // 上次读的结束偏移，下次从这里读即为顺序读
+    uint ra_end;        // 已提交预读的页的结束位置（页号）
+    int ra_pages;       // 当前预读窗口，0 表示未检测到顺序读
+};
+
+// 每个进程的 fd 表：数组按 fd 直接索引，位图查找最小空闲 fd
+// 容量从内嵌的 NFD_INLINE 项开始，用满后换成一整页
+struct fdtable {
+    int ref;                          // 共享该表的线程数，0 表示空闲
+    int size;                         // fd 数组容量
+    struct file **fd;                 // 指向 inline_fd 或整页
+    struct file *inline_fd[NFD_INLINE];
+    uint64_t open[FDMAP_WORDS];       // 已占用 fd 的位图
+};
+
+struct proc;
+struct pipe;
+
+struct file* filealloc(void);
+struct file* filedup(struct file *f);
+void fileclose(struct file *f);
+
+struct fdtable* fdt_alloc(void);
+struct fdtable* fdt_copy(struct fdtable *src);
+void fdt_put(struct fdtable *t);
+int fd_install(struct fdtable *t, struct file *f);
+struct file* fd_get(struct fdtable *t, int fd);
+struct file* fd_remove(struct fdtable *t, int fd);
+struct file* fd_lookup(int fd);
+void file_readahead(struct file *f, uint off, int n);
+
+#endif
@@ -4,20 +4,66 @@
 
 #include "riscv.h"
 
-#define MAX_OPEN_FILES 16
-#define MAX_FILE_SIZE  (64 * 1024)  // 64KB
 #define MAX_FILENAME   28
+#define NINODE         256
+#define ROOT_INUM      1
+
+// 磁盘布局：[0 未用 | 1 超级块 | 日志 | inode 块 | 位图块 | 数据块]，块大小 BSIZE = 页大小
+#define FS_MAGIC    0x46534f4d   // "MOSF"
+#define FS_VERSION  2            // 2：加入元数据日志
+#define SUPERBLOCK  1
+
+struct superblock {
+    uint magic;
+    uint version;
+    uint size;          // 总块数
+    uint ninodes;
+    uint logstart;      // 日志头块，日志块紧随其后
+    uint nlog;          // 日志区块数（含头块）
+    uint inodestart;    // 第一个 inode 块
+    uint bmapstart;     // 第一个位图块
+    uint datastart;     // 第一个数据块
+};
+
+// 文件内容用三层索引（类似 ext2 的直接/间接块）
+// 只有写入过的块才会分配，空洞不占空间，读出为 0
+#define NDIRECT     11
+#define NINDIRECT   (PGSIZE / sizeof(uint))   // 每个索引块 1024 项
+#define MAX_FILE_PAGES (NDIRECT + NINDIRECT + NINDIRECT * NINDIRECT)
+#define MAX_FILE_SIZE  0xFFFFFFFFULL           // size 字段为 32 位
+
+// 每个事务最多写 1MB：位图、索引块与 inode 合计不超过 MAXOPBLOCKS 个元数据块
+#define WRITE_CHUNK    (256 * PGSIZE)
 
 // 文件类型
 #define FT_REG  1  // 普通文件
 #define FT_DIR  2  // 目录
 
+// 磁盘上的 inode，64 字节
+struct dinode {
+    short type;         // 0 表示空闲
+    short nlink;
+    uint size;
+    uint npages;        // 已分配的数据块数
+    uint addrs[NDIRECT + 2];   // 直接块、一级间接块、二级间接块
+};
+
+#define IPB           (PGSIZE / sizeof(struct dinode))   // 每块 inode 数
+#define IBLOCK(inum)  (sb.inodestart + (inum) / IPB)
+#define BPB           (PGSIZE * 8)                       // 每个位图块管理的块数
+#define BBLOCK(b)     (sb.bmapstart + (b) / BPB)
+
+// 内存中的 inode：全部常驻，磁盘字段修改后由 iupdate 写回
 struct inode {
-    int inum;           // inode 编号
-    short type;         // FT_REG 或 FT_DIR
+    int inum;           // inode 编号（= 下标 + 1）
+    short type;         // FT_REG 或 FT_DIR，0 表示空闲
     short nlink;        // 硬链接数
+    int ref;            // 内存中的引用数（打开的文件、exec 映射）
     uint size;          // 文件大小
-    char data[MAX_FILE_SIZE];  // 文件内容（RAMFS 简化）
+    uint npages;        // 已分配的数据块数
+    uint addrs[NDIRECT + 2];
+    struct dirhash *dirhash; // 目录的名字哈希索引（按需建立，仅在内存中）
+    const char *xip;    // 非 0 时内容就是 initramfs 镜像中的这段字节，写入前才复制到磁盘块
 };
 
 struct dirent {
@@ -25,30 +71,31 @@ struct dirent {
     char name[MAX_FILENAME];
 };
 
-// 打开文件描述符
-struct file {
-    enum { FD_NONE, FD_INODE } type;
-    int ref;            // 引用计数
-    struct inode *ip;   // 指向 inode
-    uint off;           // 读写偏移
-};
+struct buf;
 
-extern struct file ftable[MAX_OPEN_FILES];
-extern struct inode root_inode;
-extern int next_inum;
+extern struct superblock sb;
+extern struct inode *root_inode;
 
 void fs_init(void);
+uint name_hash(const char *name);
 struct inode* ialloc(short type);
+struct inode* iget(uint inum);
+struct inode* idup(struct inode *ip);
+void iput(struct inode *ip);
+void itrunc(struct inode *ip);
 void iupdate(struct inode *ip);
-struct inode* namei(char *path);
-int dirlink(struct inode *dp, char *name, uint inum);
-int dirlookup(struct inode *dp, char *name, uint *poff);
-
-// 文件操作
-int sys_open(void);
-int sys_close(void);
-int sys_read(void);
-int sys_write(void);
-int sys_unlink(void);
+struct inode* namei(const char *path);
+struct inode* nameiparent(const char *path, char *name);
+struct inode* fs_create(const char *path, short type);
+int fs_unlink(const char *path);
+int fs_rmdir(const char *path);
+int dirlink(struct inode *dp, const char *name, uint inum);
+struct inode* dirlookup(struct inode *dp, const char *name, uint *poff);
+int dirunlink(struct inode *dp, const char *name);
+int readi(struct inode *ip, void *dst, uint64_t off, uint64_t n);
+void ireadahead(struct inode *ip, uint64_t pgno, int n);
+struct buf* ibread(struct inode *ip, uint64_t pgno);
+int writei(struct inode *ip, const void *src, uint64_t off, uint64_t n);
+int icopyup(struct inode *ip);
 
 #endif
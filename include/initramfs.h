@@ -0,0 +1,14 @@
+// include/initramfs.h
+#ifndef __INITRAMFS_H__
+#define __INITRAMFS_H__
+
+#include "riscv.h"
+
+// make 把 initramfs/ 目录和用户程序打包成 cpio（newc 格式），经 kernel/kernel.ld 链接进内核
+// 启动时逐项挂到文件系统上：文件内容不复制，inode 直接指向镜像中的字节（xip），
+// 第一次写入或截断时才复制到磁盘块（写时复制），磁盘上已修改过的文件优先
+extern char _initramfs_start[], _initramfs_end[];
+
+void initramfs_mount(void);
+
+#endif
@@ -0,0 +1,50 @@
+// include/journal.h
+#ifndef __JOURNAL_H__
+#define __JOURNAL_H__
+
+#include "riscv.h"
+#include "blk/blk.h"
+
+// 元数据预写日志：位图、inode、目录与索引块的修改先写入日志区，
+// 提交后再写回原位置；文件数据块不经过日志，但在提交前先写回（ordered 模式）
+//
+// 日志区大小在 mkfs 时写入超级块；提交间隔可在运行时用 journal_set_interval 调整
+#ifndef LOG_BLOCKS
+#define LOG_BLOCKS        64   // 日志区块数（含头块）
+#endif
+#ifndef LOG_COMMIT_TICKS
+#define LOG_COMMIT_TICKS  5    // 事务最多等待的时钟中断数，之后由提交线程提交
+#endif
+#define MAXOPBLOCKS       10   // 单个操作最多修改的元数据块数
+#define LOGHDR_MAX        (BSIZE / sizeof(uint) - 1)
+
+// 日志头块：n 为 0 表示日志中没有已提交的事务
+struct logheader {
+    uint n;
+    uint block[LOGHDR_MAX];
+};
+
+struct journal_stats {
+    uint64_t commits;
+    uint64_t ops;          // 已提交的操作数
+    uint64_t blocks;       // 已提交的日志块数
+    uint64_t absorbed;     // 同一事务内重复修改同一块（只记一次）
+    uint64_t by_timer;     // 提交原因：间隔到期
+    uint64_t by_space;     // 日志空间不足
+    uint64_t by_sync;      // sync
+    int max_ops;
+    int max_blocks;
+};
+extern struct journal_stats journal_stats;
+
+void journal_init(uint start, uint size);
+void begin_op(void);
+void end_op(void);
+void log_write(struct buf *b);
+void journal_sync(void);
+void journal_tick(void);
+void journal_set_interval(int ticks);
+void journal_task(void);
+void journal_stats_dump(void);
+
+#endif
@@ -0,0 +1,30 @@
+// include/klog.h
+#ifndef __KLOG_H__
+#define __KLOG_H__
+
+#include "riscv.h"
+
+// 内核日志：所有记录都写入内存中的环，只有级别不低于控制台级别的才同时输出到控制台
+// 热路径上的调试信息因此可以一直保留，需要时用 dmesg 取出
+#define KLOG_DEBUG  0
+#define KLOG_INFO   1
+#define KLOG_WARN   2
+#define KLOG_ERR    3
+
+#ifndef KLOG_NREC
+#define KLOG_NREC   256    // 环中的记录数（2 的幂），满了覆盖最旧的
+#endif
+#define KLOG_MSG    108    // 单条记录正文上限（含结尾 0），使每条记录为 128 字节
+
+struct klog_rec {
+    uint64_t seq;          // 序号 + 1；0 表示正在写入
+    uint64_t time;         // rdtime
+    int level;
+    char msg[KLOG_MSG];
+};
+
+void klog(int level, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+int klog_set_level(int level);
+int klog_read(char *buf, int len);
+
+#endif
@@ -5,5 +5,7 @@
 void pmm_init(void);
 void* alloc_page(void);
 void free_page(void *pa);
+void page_dup(void *pa);
+int page_refcnt(void *pa);
 
 #endif
@@ -6,6 +6,17 @@
 
 // 页表类型已在 riscv.h 中定义
 
+// 用户地址空间：独占根页表第 1 项（1GB），其余根页表项与内核共享
+#define USERBASE   0x40000000L
+#define USERTOP    0x80000000L
+#define USTACKTOP  0x7fff0000L             // 用户栈顶（向下增长）
+#define USTACKSIZE (16 * PGSIZE)           // 按需分配的用户栈上限
+#define URING_VA   USTACKTOP               // 提交/完成环（kernel/uring.c）
+#define VDSO_VA    (USERTOP - PGSIZE)      // vDSO 数据页（kernel/vdso.c）
+#define USER_ROOT_INDEX VPN_MASK(USERBASE, 2)
+
+extern pagetable_t kernel_pagetable;
+
 // 函数声明
 void kvminit(void);
 void kvminithart(void);
@@ -13,5 +24,13 @@ pagetable_t create_pagetable(void);
 int map_page(pagetable_t pt, uint64_t va, uint64_t pa, int perm);
 void destroy_pagetable(pagetable_t pt);
 void dump_pagetable(pagetable_t pt, int level);
+uint64_t walkaddr(pagetable_t pt, uint64_t va);
+pagetable_t uvmcreate(void);
+void uvmfree(pagetable_t pt);
+void uvmput(pagetable_t pt);
+int uvm_accessible(pagetable_t pt, uint64_t va, int write);
+uint64_t uvm_share(pagetable_t pt, uint64_t va);
+int uvm_remap(pagetable_t pt, uint64_t va, uint64_t pa);
+int uvm_cow(pagetable_t pt, uint64_t va);
 
 #endif
@@ -0,0 +1,30 @@
+// include/perf.h
+#ifndef __PERF_H__
+#define __PERF_H__
+
+#include "riscv.h"
+
+// 硬件性能计数器（kernel/perf.c）：启动时经 SBI PMU 扩展为每个事件分配一个计数器，
+// 调度时按进程累计（计数器一直在跑，切入/切出时各读一次）；没有 SBI PMU 时只有 cycle/instret
+#define PERF_CYCLES        0
+#define PERF_INSTRET       1
+#define PERF_CACHE_REFS    2
+#define PERF_CACHE_MISSES  3
+#define PERF_BRANCH_MISSES 4
+#define PERF_NEVENTS       5
+
+// perf_sample(event, period) 的参考周期：每 100 万个事件一个样本
+#define PERF_SAMPLE_PERIOD 1000000
+
+struct proc;
+struct trapframe;
+
+void perf_init(void);
+int perf_counts(struct proc *p, uint64_t *counts, int n);
+int perf_set_sampling(int event, uint64_t period);
+void perf_switch_in(struct proc *p);
+void perf_switch_out(struct proc *p);
+void perf_overflow(struct trapframe *tf, uint64_t sstatus);
+const char *perf_event_name(int event);
+
+#endif
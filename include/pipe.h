@@ -0,0 +1,40 @@
+// include/pipe.h
+#ifndef __PIPE_H__
+#define __PIPE_H__
+
+#include "riscv.h"
+
+#define NPIPE      16
+#define PIPE_BUFS  16     // 每个管道最多缓存 16 页（64KB）
+
+// 管道由一串页组成，读者从 head 取，写者往 tail 放
+// 小的写复制进管道自己的页；页对齐的整页写直接把写者的页以写时复制方式挂进管道，
+// 读者的缓冲区同样页对齐时再把这一页映射给读者，全程不复制数据
+struct pipe_buf {
+    char *page;
+    uint off;           // 未读数据在页内的起始位置
+    uint len;           // 未读字节数
+    int gift;           // 来自写者的页（写时复制共享，不能再追加）
+};
+
+struct pipe {
+    int used;
+    int readopen;       // 读端是否还有打开的文件
+    int writeopen;
+    uint head;          // 下一个读的槽（递增计数，取模使用）
+    uint tail;          // 下一个空槽
+    struct pipe_buf bufs[PIPE_BUFS];
+    uint64_t copied;    // 复制的字节数
+    uint64_t handoff;   // 移交的页数（写入端）
+    uint64_t remapped;  // 直接映射给读者的页数
+};
+
+struct file;
+
+int pipealloc(struct file **rf, struct file **wf);
+void pipeclose(struct pipe *p, int writable);
+int pipe_read(struct pipe *p, char *dst, int n);
+int pipe_write(struct pipe *p, const char *src, int n);
+void pipe_stats_dump(void);
+
+#endif
@@ -2,6 +2,13 @@
 #ifndef __PRINTF_H__
 #define __PRINTF_H__
 
-int printf(const char *fmt, ...);
+#include <stdarg.h>
+#include <stddef.h>
+
+int printf(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+int vprintf(const char *fmt, va_list ap);
+int snprintf(char *buf, size_t size, const char *fmt, ...) __attribute__((format(printf, 3, 4)));
+int vsnprintf(char *buf, size_t size, const char *fmt, va_list ap);
+void panic(const char *s) __attribute__((noreturn));
 
 #endif
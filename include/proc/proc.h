@@ -2,17 +2,21 @@
 #define __PROC_H__
 
 #include "riscv.h"
+#include "perf.h"
 
-#define NPROC 8
+#define NPROC 32
 #define PGSIZE 4096
 
 enum procstate { UNUSED, EMBRYO, RUNNABLE, RUNNING, SLEEPING, ZOMBIE };
 
+// swtch 保存的内核上下文：ra、sp 以及全部 callee-saved 寄存器
 struct context {
     uint64_t ra;
     uint64_t sp;
+    uint64_t s0, s1, s2, s3, s4, s5, s6, s7, s8, s9, s10, s11;
 };
 
+// 布局必须与 trapvec.S 中 kernelvec 的保存顺序一致
 struct trapframe {
     uint64_t epc;
     uint64_t ra, sp, gp, tp;
@@ -23,6 +27,20 @@ struct trapframe {
     uint64_t t3, t4, t5, t6;
 };
 
+// 用户地址空间中的一段映射（exec 按需加载）
+#define NVMA 8
+struct inode;
+struct uring;
+struct fdtable;
+struct vma {
+    uint64_t start, end;       // [start, end)，页对齐；end == 0 表示空闲
+    uint64_t file_va;          // 文件内容对应的起始虚拟地址（p_vaddr）
+    uint64_t off;              // 段在文件中的偏移
+    uint64_t filesz;           // 文件中的字节数，其余部分零填充
+    int perm;                  // PTE_R / PTE_W / PTE_X
+    struct inode *ip;          // 0 表示匿名映射（如用户栈）
+};
+
 struct proc {
     enum procstate state;
     int pid;
@@ -33,21 +51,95 @@ struct proc {
     int exit_status;
     int parent;
     struct trapframe *trapframe;
+
+    void *chan;                  // 非 0 表示正在该通道上睡眠
+    int tgid;                    // 线程组 ID（= 主线程 pid）
+    void (*thread_fn)(void *);   // clone 创建的线程入口
+    void *thread_arg;
+    int *clear_tid;              // 线程退出时清零并 futex 唤醒（用于 join）
+    uint64_t thread_stack;       // clone 传入的栈顶
+    uint64_t futex_addr;         // 正在等待的 futex 地址
+    struct proc *futex_next;     // futex 哈希桶等待链
+    struct vma vma[NVMA];        // exec 建立的用户映射
+    struct uring *uring;         // 提交/完成环（ring_setup）
+    uint64_t nsyscall;           // 进入内核的系统调用次数
+    uint64_t perf_count[PERF_NEVENTS];  // 硬件事件的累计值（kernel/perf.c）
+    uint64_t perf_base[PERF_NEVENTS];   // 本次被调度时各计数器的读数
+    struct fdtable *fdt;         // fd 表（同一线程组共享）
 };
+
+// futex 操作码
+#define FUTEX_WAIT 0
+#define FUTEX_WAKE 1
+
 // 用户态系统调用接口（桩函数）
+int getpid(void);
+void exit(int status);
 int open(const char *path, int flags);
 int close(int fd);
 int read(int fd, void *buf, int count);
 int write(int fd, const void *buf, int count);
 int unlink(const char *path);
+int clone(void (*fn)(void *), void *stack, void *arg, int *ctid);
+int futex(int *addr, int op, int val);
+int exec(const char *path, char **argv);
+int ring_setup(struct uring **ring);
+int ring_enter(int to_submit);
+struct iovec;
+int readv(int fd, const struct iovec *iov, int iovcnt);
+int writev(int fd, const struct iovec *iov, int iovcnt);
+int pread(int fd, void *buf, int count, int off);
+int pwrite(int fd, const void *buf, int count, int off);
+int mkdir(const char *path);
+int rmdir(const char *path);
+int dup(int fd);
+int sync(void);
+int pipe(int fds[2]);
+int sendfile(int out_fd, int in_fd, int off, int len);
+int dmesg(char *buf, int len);
+int loglevel(int level);
+int prof(int cmd, int arg);
+int perf_read(int pid, uint64_t *counts, int n);
+int perf_sample(int event, int period);
+
+// 用户态互斥锁（user/umutex.c）：无竞争时不进入内核
+struct umutex {
+    int state;   // 0 空闲，1 已加锁，2 已加锁且有等待者
+};
+
+void umutex_init(struct umutex *m);
+void umutex_lock(struct umutex *m);
+void umutex_unlock(struct umutex *m);
+int thread_create(void (*fn)(void *), void *arg, void *stack, int *tid);
+void thread_join(int *tid);
 
 // 内核函数声明
 void proc_init(void);
 int create_process(void (*entry)(void));
-void exit_process(int status);
+int create_thread(void (*fn)(void *), void *arg, uint64_t stack, int *ctid);
+void exit_process(int status) __attribute__((noreturn));
 int wait_process(int *status);
 void scheduler(void) __attribute__((noreturn));
 void swtch(struct context *old,struct context *new);
+void sched(void);
+void yield(void);
+void sleep(void *chan);
+void wakeup(void *chan);
+
+// kernel/exec.c
+int exec_load(const char *path, char **argv);
+int vma_fault(struct proc *p, uint64_t va, int kind);
+int vma_prefault(struct proc *p, uint64_t va, uint64_t len, int write);
+void vma_free(struct proc *p);
+
+// vma_fault 的缺页类型，由 scause 得到
+#define FAULT_EXEC   0   // 12：取指
+#define FAULT_READ   1   // 13：读
+#define FAULT_WRITE  2   // 15：写
+
+// kernel/proc/futex.c
+int futex_wait(int *addr, int val);
+int futex_wake(int *addr, int nwake);
 
 
 extern struct proc proc[];
@@ -0,0 +1,31 @@
+// include/prof.h
+#ifndef __PROF_H__
+#define __PROF_H__
+
+#include "riscv.h"
+
+// 时钟中断采样 profiler：开启后时钟中断额外按采样频率触发，每次记录被打断的 pc、pid
+// 与帧指针调用链；相同的 (pid, 调用链) 在内核里合并计数，dump 的输出由 scripts/prof.py 符号化
+#define PROF_DEPTH      8       // 每个样本最多记录的帧数（含被打断的 pc）
+#define PROF_NSTACKS    1024    // 不同调用链的上限（2 的幂），表满后的新调用链只计入 dropped
+#define PROF_HZ_DEFAULT 1000
+#define PROF_HZ_MAX     10000
+#define PROF_SECS       10      // 由启动参数开启时，默认采样多少秒后输出
+
+// prof(cmd, arg) 系统调用的命令
+#define PROF_START  0   // arg 为采样频率（Hz），0 取默认值；已在采样时返回 -1
+#define PROF_STOP   1   // 返回已记录的样本数，没有在采样时返回 -1
+#define PROF_DUMP   2   // 把合并后的调用链输出到控制台
+#define PROF_RESET  3   // 清空采样表
+
+struct trapframe;
+
+int prof_init(void);
+int prof_ctl(int cmd, int arg);
+uint64_t prof_deadline(uint64_t now, uint64_t next_tick);
+void prof_sample(struct trapframe *tf, uint64_t sstatus);
+void prof_record(struct trapframe *tf, uint64_t sstatus);
+void prof_dump(void);
+void prof_task(void);
+
+#endif
@@ -5,6 +5,9 @@
 #include <stdint.h>
 #include <stddef.h>
 
+typedef unsigned int   uint;
+typedef unsigned short ushort;
+
 // 页大小 4KB
 #define PGSIZE 4096
 #define PGSHIFT 12
@@ -12,13 +15,29 @@
 // 页对齐宏
 #define PGROUNDUP(sz)  (((sz) + PGSIZE - 1) & ~(PGSIZE - 1))
 #define PGROUNDDOWN(a) ((a) & ~(PGSIZE - 1))
+#define MEGAPAGE       (1UL << 21)   // Sv39 第 1 级叶子映射的大小
 
 // Sv39 虚拟地址布局
 #define KERNBASE 0x80000000L  // 内核起始虚拟地址
-#define PHYSTOP  0x88000000L  // 物理内存结束地址（128MB）
+#define PHYSTOP  0x88000000L  // 没有设备树时假定的物理内存结束地址（128MB），实际大小见 fdt.h
 
+// 以下设备地址是 QEMU virt 的默认值，启动时以设备树为准（struct machine）
 // UART 设备物理地址（QEMU virt 平台）
 #define UART0 0x10000000L
+#define UART0_IRQ 10
+
+// virtio MMIO 槽位：8 个，间隔 0x1000，中断号 1..8
+#define VIRTIO0      0x10001000L
+#define VIRTIO_SLOTS 8
+#define VIRTIO0_IRQ  1
+
+// PLIC 中断控制器
+#define PLIC 0x0c000000L
+
+// SiFive test finisher：写 0x5555 退出 QEMU（成功），写 (code << 16) | 0x3333 以 code 退出
+#define TEST_FINISHER   0x100000L
+#define FINISHER_PASS   0x5555
+#define FINISHER_FAIL   0x3333
 
 // 页表项（PTE）相关
 typedef uint64_t pte_t;
@@ -30,6 +49,8 @@ typedef uint64_t* pagetable_t;
 #define PTE_W (1L << 2)  // Write
 #define PTE_X (1L << 3)  // Execute
 #define PTE_U (1L << 4)  // User
+#define PTE_SHARED (1L << 8)  // 软件位（RSW）：共享页，uvmfree 时不释放
+#define PTE_COW    (1L << 9)  // 软件位（RSW）：写时复制，写缺页时复制或恢复 PTE_W
 
 // 从 PTE 提取物理页号（PPN）
 #define PTE2PPN(pte) (((pte) >> 10) << 12)
@@ -55,6 +76,9 @@ static inline void sfence_vma() {
     asm volatile("sfence.vma");
 }
 
+// rdtime 频率：QEMU virt 为 10MHz
+#define TIMEBASE_FREQ 10000000UL
+
 // 读取机器时间（mtime）
 static inline uint64_t r_time() {
     uint64_t x;
@@ -63,6 +87,25 @@ static inline uint64_t r_time() {
 }
 
 
+// 周期计数（需要 M 模式固件在 mcounteren 中开放）
+static inline uint64_t r_cycle() {
+    uint64_t x;
+    asm volatile("rdcycle %0" : "=r" (x));
+    return x;
+}
+
+static inline uint64_t r_instret() {
+    uint64_t x;
+    asm volatile("rdinstret %0" : "=r" (x));
+    return x;
+}
+
+// Zicboz：把 addr 所在的缓存块清零；老工具链不认识 cbo.zero 助记符，用 .insn 编码
+#define CBO_BLOCK 64   // QEMU 默认的 cboz 块大小
+static inline void cbo_zero(void *addr) {
+    asm volatile(".insn i 0x0f, 2, x0, %0, 4" :: "r" (addr) : "memory");
+}
+
 // SATP 寄存器值构造宏
 #define MAKE_SATP(pagetable) (((uint64_t)(pagetable) >> 12) | (8ULL << 60))
 
@@ -90,10 +133,34 @@ static inline void w_sstatus(uint64_t x) { asm volatile("csrw sstatus, %0" :: "r
 static inline uint64_t r_sie() { uint64_t x; asm volatile("csrr %0, sie" : "=r" (x)); return x; }
 static inline void w_sie(uint64_t x) { asm volatile("csrw sie, %0" :: "r" (x)); }
 static inline uint64_t r_sip() { uint64_t x; asm volatile("csrr %0, sip" : "=r" (x)); return x; }
+static inline void w_sip(uint64_t x) { asm volatile("csrw sip, %0" :: "r" (x)); }
+// Sscofpmf：溢出的计数器位图（老工具链不认识 scountovf，用编号）
+static inline uint64_t r_scountovf() { uint64_t x; asm volatile("csrr %0, 0xda0" : "=r" (x)); return x; }
 static inline uint64_t r_scause() { uint64_t x; asm volatile("csrr %0, scause" : "=r" (x)); return x; }
 static inline uint64_t r_sepc() { uint64_t x; asm volatile("csrr %0, sepc" : "=r" (x)); return x; }
 static inline void w_sepc(uint64_t x) { asm volatile("csrw sepc, %0" :: "r" (x)); }
 static inline void w_stvec(uint64_t x) { asm volatile("csrw stvec, %0" :: "r" (x)); }
+static inline uint64_t r_stval() { uint64_t x; asm volatile("csrr %0, stval" : "=r" (x)); return x; }
+
+// sstatus 位
+#define SSTATUS_SIE  (1L << 1)   // S 模式中断使能
+#define SSTATUS_SPIE (1L << 5)   // trap 前的 SIE
+#define SSTATUS_SPP  (1L << 8)   // trap 前的特权级（1 = S 模式）
+#define SSTATUS_SUM  (1L << 18)  // 允许 S 模式访问 U 页
+#define SSTATUS_VS   (3L << 9)   // 向量单元状态，没有 V 扩展时只读为 0
+#define SSTATUS_VS_INITIAL (1L << 9)
+
+// scause：最高位为 1 表示中断
+#define SCAUSE_INTR  (1UL << 63)
+
+// sie/sip 中的本地计数器溢出中断（Sscofpmf，中断号 13）
+#define SIE_LCOFIE   (1L << 13)
+#define SIP_LCOFIP   (1L << 13)
+
+// 开/关 S 模式中断
+static inline void intr_on() { w_sstatus(r_sstatus() | SSTATUS_SIE); }
+static inline void intr_off() { w_sstatus(r_sstatus() & ~SSTATUS_SIE); }
+static inline int intr_get() { return (r_sstatus() & SSTATUS_SIE) != 0; }
 
 
 #endif
@@ -11,5 +11,16 @@ int strcmp(const char *s1, const char *s2);
 char* strcpy(char *dst, const char *src);
 size_t strlen(const char *s);
 char* strchr(const char *s, int c);
+void page_zero(void *pg);
+
+// 启动时由 cpu_probe 设置；基准测试可临时清零以测量标量路径
+extern int string_use_rvv;
+extern int string_use_cboz;
+
+// kernel/string_rvv.S：只在 string_use_rvv 时调用
+void memcpy_rvv(void *dst, const void *src, uint64_t n);
+void memset_rvv(void *dst, int c, uint64_t n);
+size_t strlen_rvv(const char *s);
+int strcmp_rvv(const char *s1, const char *s2);
 
 #endif
@@ -2,6 +2,8 @@
 #ifndef __SYSCALL_H__
 #define __SYSCALL_H__
 
+#include "riscv.h"
+
 #define SYS_getpid 1
 #define SYS_fork   2
 #define SYS_exit   3
@@ -11,9 +13,48 @@
 #define SYS_close   7
 #define SYS_read    8
 #define SYS_unlink  9
+#define SYS_clone   10
+#define SYS_futex   11
+#define SYS_exec    12
+#define SYS_ring_setup 13
+#define SYS_ring_enter 14
+#define SYS_readv   15
+#define SYS_writev  16
+#define SYS_pread   17
+#define SYS_pwrite  18
+#define SYS_mkdir   19
+#define SYS_rmdir   20
+#define SYS_dup     21
+#define SYS_sync    22
+#define SYS_pipe    23
+#define SYS_sendfile 24
+#define SYS_dmesg   25
+#define SYS_loglevel 26
+#define SYS_prof    27
+#define SYS_perf_read 28
+#define SYS_perf_sample 29
+
 
+// readv/writev 的缓冲区描述
+#define IOV_MAX 16
+struct iovec {
+    void *base;
+    int len;
+};
 
 void syscall_dispatch(void);
+int user_range_ok(uint64_t base, uint64_t len);
+
+// 文件操作（系统调用与提交环共用）
+int file_open(const char *path, int flags);
+int file_close(int fd);
+int file_dup(int fd);
+int file_read(int fd, void *buf, int count);
+int file_write(int fd, const void *buf, int count);
+int file_unlink(const char *path);
+int file_sendfile(int out_fd, int in_fd, int off, int len);
+int file_readv(int fd, const struct iovec *iov, int iovcnt, int off);
+int file_writev(int fd, const struct iovec *iov, int iovcnt, int off);
 
 
 #endif
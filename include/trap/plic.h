@@ -0,0 +1,19 @@
+// include/trap/plic.h
+#ifndef __PLIC_H__
+#define __PLIC_H__
+
+#include "riscv.h"
+#include "fdt.h"
+
+// 只使用 hart 0 的 S 模式上下文（context 1）
+#define PLIC_PRIORITY(irq)  (machine.plic + (irq) * 4)
+#define PLIC_SENABLE        (machine.plic + 0x2080)
+#define PLIC_STHRESHOLD     (machine.plic + 0x201000)
+#define PLIC_SCLAIM         (machine.plic + 0x201004)
+
+void plic_init(void);
+void plic_enable(int irq);
+int plic_claim(void);
+void plic_complete(int irq);
+
+#endif
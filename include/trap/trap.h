@@ -5,13 +5,26 @@
 #include <stdint.h>          // ✅ 必须包含！定义 uint64_t 等类型
 #include "riscv.h"           // 可选，但建议保留（如果你在 trap.h 中用到 CSR）
 
+// 调度节拍间隔（rdtime 计数）；vDSO 把它导出给用户态换算 tick
+#define TICK_INTERVAL 1000000UL
+
 //声明汇编中定义的符号
 extern void kernelvec(void);
 
 void trap_init(void);
-void kerneltrap(void);
+struct trapframe;
+void kerneltrap(struct trapframe *tf);
+void userret(struct trapframe *tf) __attribute__((noreturn));
 
 // SBI 调用（用于设置时钟）
 void sbi_set_timer(uint64_t stime_value);
 
+// 通用 SBI 调用：ext/fid 为扩展号与函数号，error 为 0 表示成功
+struct sbiret {
+    long error;
+    long value;
+};
+struct sbiret sbi_call(uint64_t ext, uint64_t fid, uint64_t a0, uint64_t a1,
+                       uint64_t a2, uint64_t a3, uint64_t a4);
+
 #endif
@@ -2,7 +2,13 @@
 #ifndef __UART_H__
 #define __UART_H__
 
+#define UART_FIFO 16   // 发送 FIFO 深度
+
 void uart_init(void);
+int uart_tx_ready(void);
+void uart_tx(char c);
+void uart_tx_intr(int on);
 void uart_putc(char c);
+void uart_intr(void);
 
 #endif
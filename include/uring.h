@@ -0,0 +1,99 @@
+// include/uring.h
+// 每进程一对共享内存提交/完成队列（io_uring 风格）
+// 用户填写 SQE 后推进 sq_tail，一次 ring_enter 处理多个操作，结果写入 CQ
+#ifndef __URING_H__
+#define __URING_H__
+
+#include "riscv.h"
+
+#define URING_SQ_ENTRIES 32   // 必须是 2 的幂
+#define URING_CQ_ENTRIES 64
+
+// 操作码
+enum {
+    URING_OP_NOP = 0,
+    URING_OP_OPEN,     // addr = 路径，len = flags
+    URING_OP_CLOSE,    // fd
+    URING_OP_READ,     // fd, addr = 缓冲区, len
+    URING_OP_WRITE,    // fd, addr = 缓冲区, len
+    URING_OP_UNLINK,   // addr = 路径
+};
+
+// 提交队列项（32 字节）
+struct uring_sqe {
+    uint8_t  opcode;
+    uint8_t  flags;
+    uint16_t resv;
+    int32_t  fd;
+    uint64_t addr;
+    uint32_t len;
+    uint32_t resv2;
+    uint64_t user_data;   // 原样带回 CQE
+};
+
+// 完成队列项（16 字节）
+struct uring_cqe {
+    uint64_t user_data;
+    int32_t  res;         // 与对应系统调用的返回值相同
+    uint32_t flags;
+};
+
+// 共享页布局：sq_tail / cq_head 由用户写，sq_head / cq_tail 由内核写
+struct uring {
+    uint32_t sq_head;
+    uint32_t sq_tail;
+    uint32_t cq_head;
+    uint32_t cq_tail;
+    uint32_t dropped;     // 保留
+    uint32_t resv[11];
+    struct uring_sqe sq[URING_SQ_ENTRIES];
+    struct uring_cqe cq[URING_CQ_ENTRIES];
+};
+
+_Static_assert(sizeof(struct uring) <= PGSIZE, "struct uring must fit in one page");
+
+// ---------- 用户侧辅助函数 ----------
+
+// 取下一个空闲 SQE，队列满时返回 0
+static inline struct uring_sqe* uring_get_sqe(struct uring *r) {
+    uint32_t head = __atomic_load_n(&r->sq_head, __ATOMIC_ACQUIRE);
+    if (r->sq_tail - head >= URING_SQ_ENTRIES) {
+        return 0;
+    }
+    struct uring_sqe *sqe = &r->sq[r->sq_tail & (URING_SQ_ENTRIES - 1)];
+    sqe->flags = 0;
+    sqe->resv = 0;
+    sqe->resv2 = 0;
+    return sqe;
+}
+
+// 发布已填写的 SQE
+static inline void uring_advance_sq(struct uring *r) {
+    __atomic_store_n(&r->sq_tail, r->sq_tail + 1, __ATOMIC_RELEASE);
+}
+
+// 尚未被内核消费的 SQE 数
+static inline uint32_t uring_sq_pending(struct uring *r) {
+    return r->sq_tail - __atomic_load_n(&r->sq_head, __ATOMIC_ACQUIRE);
+}
+
+// 取下一个完成项，没有则返回 0
+static inline struct uring_cqe* uring_peek_cqe(struct uring *r) {
+    uint32_t tail = __atomic_load_n(&r->cq_tail, __ATOMIC_ACQUIRE);
+    if (r->cq_head == tail) {
+        return 0;
+    }
+    return &r->cq[r->cq_head & (URING_CQ_ENTRIES - 1)];
+}
+
+static inline void uring_cqe_seen(struct uring *r) {
+    __atomic_store_n(&r->cq_head, r->cq_head + 1, __ATOMIC_RELEASE);
+}
+
+// kernel/uring.c
+struct proc;
+struct uring* uring_setup(struct proc *p);
+int uring_enter(struct proc *p, int to_submit);
+void uring_free(struct proc *p);
+
+#endif
@@ -0,0 +1,56 @@
+// include/vdso.h
+// 只读共享数据页（vDSO 风格）：内核维护，映射到每个进程的 VDSO_VA
+// 用户读取 pid、时钟无需 trap
+#ifndef __VDSO_H__
+#define __VDSO_H__
+
+#include "riscv.h"
+#include "mm/vm.h"
+
+struct vdso_data {
+    uint32_t seq;              // 序列锁：奇数表示内核正在更新
+    uint32_t pid;              // 当前 CPU 上运行的进程（调度时更新）
+    uint64_t ticks;            // 时钟中断次数
+    uint64_t timebase_freq;    // rdtime 频率（Hz）
+    uint64_t tick_interval;    // 每个 tick 的 rdtime 计数
+    uint64_t boot_time;        // 启动时的 rdtime 值
+};
+
+// ---------- 用户侧读取函数 ----------
+
+static inline const volatile struct vdso_data* vdso_page(void) {
+    return (const volatile struct vdso_data*)VDSO_VA;
+}
+
+static inline int vdso_getpid(void) {
+    return vdso_page()->pid;
+}
+
+static inline uint64_t vdso_ticks(void) {
+    const volatile struct vdso_data *vd = vdso_page();
+    uint32_t seq;
+    uint64_t ticks;
+    do {
+        seq = vd->seq;
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        ticks = vd->ticks;
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    } while ((seq & 1) || seq != vd->seq);
+    return ticks;
+}
+
+// 自启动以来的纳秒数：rdtime + 页中的校准数据
+static inline uint64_t vdso_clock_ns(void) {
+    const volatile struct vdso_data *vd = vdso_page();
+    uint64_t delta = r_time() - vd->boot_time;
+    uint64_t freq = vd->timebase_freq;
+    return (delta / freq) * 1000000000ULL + (delta % freq) * 1000000000ULL / freq;
+}
+
+// ---------- 内核接口（kernel/vdso.c）----------
+void vdso_init(void);
+int vdso_map(pagetable_t pt);
+void vdso_tick(void);
+void vdso_set_pid(int pid);
+
+#endif
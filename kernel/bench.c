@@ -0,0 +1,768 @@
+// kernel/bench.c
+// 微基准测试：在进程上下文中运行，用 rdtime 计时
+// 只在 make bench 构建的内核里运行（main.c 中的 BENCH），结束后关机
+#include "riscv.h"
+#include "printf.h"
+#include "string.h"
+#include "bench.h"
+#include "vdso.h"
+#include "fs.h"
+#include "dcache.h"
+#include "blk/blk.h"
+#include "journal.h"
+#include "syscall.h"
+#include "proc/proc.h"
+#include "mm/pmm.h"
+#include "mm/vm.h"
+#include "fdt.h"
+#include "perf.h"
+#include "pipe.h"
+
+#define BENCH_ITERS 10000
+
+// rdtime 计数 -> 纳秒
+static uint64_t time_to_ns(uint64_t t) {
+    return t * 1000000000ULL / vdso_page()->timebase_freq;
+}
+
+// getpid：ecall 路径 vs vDSO 路径；以及 vDSO 时钟读取
+void bench_vdso(void) {
+    volatile uint64_t sink = 0;
+    uint64_t t0, t_trap, t_vdso, t_clock;
+
+    t0 = r_time();
+    for (int i = 0; i < BENCH_ITERS; i++) {
+        sink += getpid();
+    }
+    t_trap = r_time() - t0;
+
+    t0 = r_time();
+    for (int i = 0; i < BENCH_ITERS; i++) {
+        sink += vdso_getpid();
+    }
+    t_vdso = r_time() - t0;
+
+    t0 = r_time();
+    for (int i = 0; i < BENCH_ITERS; i++) {
+        sink += vdso_clock_ns();
+    }
+    t_clock = r_time() - t0;
+
+    if (getpid() != vdso_getpid()) {
+        printf("bench_vdso: pid mismatch %d != %d\n", getpid(), vdso_getpid());
+    }
+
+    printf("bench_vdso: %d iters\n", BENCH_ITERS);
+    printf("  getpid (ecall): %d ns/call\n", (int)(time_to_ns(t_trap) / BENCH_ITERS));
+    printf("  getpid (vdso):  %d ns/call\n", (int)(time_to_ns(t_vdso) / BENCH_ITERS));
+    printf("  clock_ns (vdso): %d ns/call\n", (int)(time_to_ns(t_clock) / BENCH_ITERS));
+}
+
+// 生成目录项名 "f<i>"
+static void bench_name(char *buf, int i) {
+    char tmp[12];
+    int n = 0;
+    do {
+        tmp[n++] = '0' + i % 10;
+        i /= 10;
+    } while (i);
+    *buf++ = 'f';
+    while (n) *buf++ = tmp[--n];
+    *buf = 0;
+}
+
+// 目录查找：不同目录大小下命中与未命中的平均耗时
+// 目录项都是指向同一 inode 的硬链接，不受 NINODE 限制
+void bench_dirlookup(void) {
+    static const int sizes[] = { 16, 256, 4096, 16384 };
+    char name[16];
+
+    if (mkdir("/bench") < 0) {
+        printf("bench_dirlookup: mkdir failed\n");
+        return;
+    }
+    struct inode *dp = namei("/bench");
+    begin_op();
+    struct inode *ip = fs_create("/bench/target", FT_REG);
+    end_op();
+    if (dp == 0 || ip == 0) {
+        printf("bench_dirlookup: create failed\n");
+        return;
+    }
+
+    printf("bench_dirlookup: %d lookups per size\n", BENCH_ITERS);
+    int nent = 1;  // "target"
+    for (int s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        for (; nent < sizes[s]; nent++) {
+            bench_name(name, nent);
+            begin_op();
+            int r = dirlink(dp, name, ip->inum);
+            end_op();
+            if (r < 0) break;
+            ip->nlink++;
+        }
+        begin_op();
+        iupdate(ip);
+        end_op();
+        if (nent < sizes[s]) {
+            printf("bench_dirlookup: only %d entries\n", nent);
+            break;
+        }
+
+        uint64_t t0, t_hit, t_miss;
+        uint32_t x = 12345;
+        int found = 0;
+
+        t0 = r_time();
+        for (int i = 0; i < BENCH_ITERS; i++) {
+            x = x * 1103515245 + 12345;
+            bench_name(name, 1 + (x >> 8) % (nent - 1));
+            found += dirlookup(dp, name, 0) != 0;
+        }
+        t_hit = r_time() - t0;
+
+        t0 = r_time();
+        for (int i = 0; i < BENCH_ITERS; i++) {
+            bench_name(name, nent + i);
+            found += dirlookup(dp, name, 0) != 0;
+        }
+        t_miss = r_time() - t0;
+
+        if (found != BENCH_ITERS) {
+            printf("bench_dirlookup: %d/%d lookups hit\n", found, BENCH_ITERS);
+        }
+        printf("  %d entries: hit %d ns, miss %d ns\n", nent,
+               (int)(time_to_ns(t_hit) / BENCH_ITERS), (int)(time_to_ns(t_miss) / BENCH_ITERS));
+    }
+
+    for (int i = 1; i < nent; i++) {
+        bench_name(name, i);
+        begin_op();
+        dirunlink(dp, name);
+        end_op();
+    }
+    unlink("/bench/target");
+    rmdir("/bench");
+}
+
+// 热路径反复解析：目录项缓存命中后不再访问目录内容
+void bench_namei(void) {
+    static const char *dirs[] = { "/n1", "/n1/n2", "/n1/n2/n3", "/n1/n2/n3/n4" };
+    static const char *path = "/n1/n2/n3/n4/file";
+    volatile uint64_t sink = 0;
+    int ndirs = sizeof(dirs) / sizeof(dirs[0]);
+
+    for (int i = 0; i < ndirs; i++) {
+        mkdir(dirs[i]);
+    }
+    begin_op();
+    struct inode *ip = fs_create(path, FT_REG);
+    end_op();
+    if (ip == 0) {
+        printf("bench_namei: create failed\n");
+        return;
+    }
+
+    struct dcache_stats before = dcache_stats;
+    uint64_t t0 = r_time();
+    for (int i = 0; i < BENCH_ITERS; i++) {
+        sink += (uint64_t)namei(path);
+    }
+    uint64_t t_hot = r_time() - t0;
+
+    t0 = r_time();
+    for (int i = 0; i < BENCH_ITERS; i++) {
+        sink += (uint64_t)namei("/n1/n2/n3/n4/missing");
+    }
+    uint64_t t_neg = r_time() - t0;
+
+    printf("bench_namei: %d iters, depth %d\n", BENCH_ITERS, ndirs + 1);
+    printf("  hot path: %d ns/lookup\n", (int)(time_to_ns(t_hot) / BENCH_ITERS));
+    printf("  missing:  %d ns/lookup\n", (int)(time_to_ns(t_neg) / BENCH_ITERS));
+    printf("  dcache: +%d hits, +%d negative hits, +%d misses\n",
+           (int)(dcache_stats.hits - before.hits),
+           (int)(dcache_stats.neg_hits - before.neg_hits),
+           (int)(dcache_stats.misses - before.misses));
+
+    unlink(path);
+    for (int i = ndirs - 1; i >= 0; i--) {
+        rmdir(dirs[i]);
+    }
+}
+
+// 顺序写 1MB 后 sync：统计块层把多少个块合并成了多少个设备请求
+#define BLK_BENCH_BLOCKS 256
+
+void bench_blk(void) {
+    static char block[BSIZE];
+    memset(block, 'b', sizeof(block));
+
+    int fd = open("/blkbench", 1);
+    if (fd < 0) {
+        printf("bench_blk: open failed\n");
+        return;
+    }
+    sync();
+
+    struct blk_stats before = blk_stats;
+    uint64_t t0 = r_time();
+    for (int i = 0; i < BLK_BENCH_BLOCKS; i++) {
+        write(fd, block, sizeof(block));
+    }
+    sync();
+    uint64_t t = r_time() - t0;
+
+    printf("bench_blk: %d x 4KB sequential writes + sync: %d us\n",
+           BLK_BENCH_BLOCKS, (int)(time_to_ns(t) / 1000));
+    printf("  %d blocks -> %d device requests, %d notifies\n",
+           (int)(blk_stats.bios - before.bios),
+           (int)(blk_stats.requests - before.requests),
+           (int)(blk_stats.kicks - before.kicks));
+
+    close(fd);
+    unlink("/blkbench");
+    sync();
+    blk_stats_dump();
+}
+
+// 流式读：4MB 文件（页缓存只有 1MB）先顺序读前 2MB，再倒序逐页 pread 之后的 1MB
+// 倒序访问不触发预读，每页都是一次同步的设备读
+#define RA_BENCH_MB 4
+
+static int bench_mbps(uint64_t bytes, uint64_t t) {
+    uint64_t us = time_to_ns(t) / 1000;
+    return us ? (int)(bytes / us) : 0;  // 字节/微秒 = MB/s
+}
+
+void bench_readahead(void) {
+    static char chunk[16 * BSIZE];
+    int fsize = RA_BENCH_MB << 20;
+
+    int fd = open("/rabench", 1);
+    if (fd < 0) {
+        printf("bench_readahead: open failed\n");
+        return;
+    }
+    memset(chunk, 'r', sizeof(chunk));
+    for (int off = 0; off < fsize; off += sizeof(chunk)) {
+        write(fd, chunk, sizeof(chunk));
+    }
+    sync();
+    close(fd);
+
+    fd = open("/rabench", 0);
+    struct pcache_stats before = pcache_stats;
+    uint64_t t0 = r_time();
+    for (int off = 0; off < fsize / 2; off += BSIZE) {
+        read(fd, chunk, BSIZE);
+    }
+    uint64_t t_seq = r_time() - t0;
+    int ra = pcache_stats.ra_blocks - before.ra_blocks;
+    int ra_hits = pcache_stats.ra_hits - before.ra_hits;
+
+    t0 = r_time();
+    for (int off = fsize / 2 + (1 << 20) - BSIZE; off >= fsize / 2; off -= BSIZE) {
+        pread(fd, chunk, BSIZE, off);
+    }
+    uint64_t t_rev = r_time() - t0;
+
+    printf("bench_readahead: 4KB reads\n");
+    printf("  sequential 2MB: %d MB/s (%d blocks read ahead, %d hit)\n",
+           bench_mbps(fsize / 2, t_seq), ra, ra_hits);
+    printf("  reverse 1MB:    %d MB/s\n", bench_mbps(1 << 20, t_rev));
+    printf("  flusher: %d batches, %d blocks\n",
+           (int)pcache_stats.flushes, (int)pcache_stats.flush_blocks);
+
+    close(fd);
+    unlink("/rabench");
+}
+
+// 组提交：几个线程同时创建、写入、删除小文件，统计每次日志提交合并了多少个操作
+#define JBENCH_THREADS 4
+#define JBENCH_FILES   32
+
+static void jbench_worker(void *arg) {
+    char path[16] = "/j";
+    char data[64];
+    int id = (int)(uint64_t)arg;
+
+    memset(data, 'j', sizeof(data));
+    for (int i = 0; i < JBENCH_FILES; i++) {
+        bench_name(path + 2, id * JBENCH_FILES + i);
+        int fd = file_open(path, 1);
+        if (fd < 0) continue;
+        file_write(fd, data, sizeof(data));
+        file_close(fd);
+        file_unlink(path);
+    }
+}
+
+static void bench_journal_run(int interval) {
+    static int tids[JBENCH_THREADS];
+
+    journal_set_interval(interval);
+    journal_sync();
+    struct journal_stats before = journal_stats;
+
+    uint64_t t0 = r_time();
+    for (int i = 0; i < JBENCH_THREADS; i++) {
+        if (create_thread(jbench_worker, (void*)(uint64_t)i, 0, &tids[i]) < 0) {
+            tids[i] = 0;
+        }
+    }
+    for (int i = 0; i < JBENCH_THREADS; i++) {
+        while (__atomic_load_n(&tids[i], __ATOMIC_ACQUIRE) != 0) {
+            yield();
+        }
+    }
+    journal_sync();
+    uint64_t t = r_time() - t0;
+
+    int commits = journal_stats.commits - before.commits;
+    int ops = journal_stats.ops - before.ops;
+    printf("  interval %d ticks: %d ops in %d commits (%d ops/commit), %d blocks logged, %d us\n",
+           interval, ops, commits, commits ? ops / commits : 0,
+           (int)(journal_stats.blocks - before.blocks), (int)(time_to_ns(t) / 1000));
+}
+
+void bench_journal(void) {
+    printf("bench_journal: %d threads x %d create/write/close/unlink\n",
+           JBENCH_THREADS, JBENCH_FILES);
+    bench_journal_run(1);
+    bench_journal_run(LOG_COMMIT_TICKS);
+    journal_stats_dump();
+}
+
+// 复制 1MB 文件：read/write 经用户缓冲区 vs sendfile 直接从缓存页写出
+#define SF_BENCH_SIZE (1 << 20)
+
+static uint64_t copy_file(int use_sendfile) {
+    static char chunk[BSIZE];
+    int in = open("/sfsrc", 0);
+    int out = open("/sfdst", 1);
+    if (in < 0 || out < 0) {
+        printf("bench_sendfile: open failed\n");
+        return 0;
+    }
+
+    uint64_t t0 = r_time();
+    if (use_sendfile) {
+        sendfile(out, in, -1, SF_BENCH_SIZE);
+    } else {
+        int n;
+        while ((n = read(in, chunk, sizeof(chunk))) > 0) {
+            write(out, chunk, n);
+        }
+    }
+    uint64_t t = r_time() - t0;
+
+    close(in);
+    close(out);
+    unlink("/sfdst");
+    return t;
+}
+
+void bench_sendfile(void) {
+    static char chunk[16 * BSIZE];
+
+    int fd = open("/sfsrc", 1);
+    if (fd < 0) {
+        printf("bench_sendfile: create failed\n");
+        return;
+    }
+    memset(chunk, 's', sizeof(chunk));
+    for (int off = 0; off < SF_BENCH_SIZE; off += sizeof(chunk)) {
+        write(fd, chunk, sizeof(chunk));
+    }
+    close(fd);
+
+    copy_file(0);  // 预热：源文件进入页缓存
+    uint64_t t_rw = copy_file(0);
+    uint64_t t_sf = copy_file(1);
+    printf("bench_sendfile: copy 1MB file\n");
+    printf("  read+write 4KB: %d us (%d syscalls)\n",
+           (int)(time_to_ns(t_rw) / 1000), 2 * SF_BENCH_SIZE / BSIZE + 1);
+    printf("  sendfile:       %d us (1 syscall)\n", (int)(time_to_ns(t_sf) / 1000));
+    unlink("/sfsrc");
+}
+
+// 管道吞吐：读写两端各是一个用户进程（/pipebench），继承这里创建的管道
+static char pipe_rfd[12], pipe_wfd[12];
+static char *pipe_argv_r[] = { "pipebench", "r", pipe_rfd, pipe_wfd, 0 };
+static char *pipe_argv_w[] = { "pipebench", "w", pipe_rfd, pipe_wfd, 0 };
+
+static void pipebench_reader(void) {
+    exec("/pipebench", pipe_argv_r);
+    exit(1);
+}
+
+static void pipebench_writer(void) {
+    exec("/pipebench", pipe_argv_w);
+    exit(1);
+}
+
+void bench_pipe(void) {
+    int fds[2];
+
+    if (pipe(fds) < 0) {
+        printf("bench_pipe: pipe failed\n");
+        return;
+    }
+    snprintf(pipe_rfd, sizeof(pipe_rfd), "%d", fds[0]);
+    snprintf(pipe_wfd, sizeof(pipe_wfd), "%d", fds[1]);
+    int r = create_process(pipebench_reader);
+    int w = create_process(pipebench_writer);
+    close(fds[0]);
+    close(fds[1]);
+
+    // 等两端都退出，之后的测试（以及关机）不会截断它们的输出
+    for (int left = (r > 0) + (w > 0); left > 0; ) {
+        int pid = wait_process(0);
+        if (pid == r || pid == w) left--;
+    }
+    pipe_stats_dump();
+}
+
+// 格式化吞吐：典型的内核日志行（64 位地址 + 宽度填充）
+// snprintf 只测格式化本身；printf 再加上追加到控制台环（行数少，环不会写满）
+#define PRINTF_BENCH_LINES 32
+
+// 累计计时：rdtime 换算成纳秒，rdcycle 反映频率变化与模拟开销
+struct bclock {
+    uint64_t t0, c0;
+    uint64_t t, c;
+};
+
+static inline void bc_start(struct bclock *b) {
+    b->t0 = r_time();
+    b->c0 = r_cycle();
+}
+
+static inline void bc_stop(struct bclock *b) {
+    b->c += r_cycle() - b->c0;
+    b->t += r_time() - b->t0;
+}
+
+// bench_printf 与 suite_printf 共用的两段循环，耗时分别累计到 fmt 与 print
+static void printf_loops(struct bclock *fmt, struct bclock *print) {
+    char line[128];
+
+    bc_start(fmt);
+    for (int i = 0; i < BENCH_ITERS; i++) {
+        snprintf(line, sizeof(line), "map_page: va=0x%016lx pa=0x%016lx perm=0x%x [%8d]\n",
+                 USERBASE + (uint64_t)i * PGSIZE, KERNBASE + (uint64_t)i * PGSIZE, 0x1e, i);
+    }
+    bc_stop(fmt);
+
+    bc_start(print);
+    for (int i = 0; i < PRINTF_BENCH_LINES; i++) {
+        printf("  line %2d: va=0x%016lx pa=0x%016lx perm=0x%x\n",
+               i, USERBASE + (uint64_t)i * PGSIZE, KERNBASE + (uint64_t)i * PGSIZE, 0x1e);
+    }
+    bc_stop(print);
+}
+
+void bench_printf(void) {
+    struct bclock fmt = {0}, print = {0};
+
+    printf_loops(&fmt, &print);
+
+    uint64_t ns_fmt = time_to_ns(fmt.t), ns_print = time_to_ns(print.t);
+    printf("bench_printf: %d lines\n", BENCH_ITERS);
+    printf("  snprintf: %lu lines/s (%lu ns/line)\n",
+           ns_fmt ? BENCH_ITERS * 1000000000UL / ns_fmt : 0, ns_fmt / BENCH_ITERS);
+    printf("  printf:   %lu lines/s (%lu ns/line, %d lines)\n",
+           ns_print ? PRINTF_BENCH_LINES * 1000000000UL / ns_print : 0,
+           ns_print / PRINTF_BENCH_LINES, PRINTF_BENCH_LINES);
+}
+
+// 字符串函数：各长度与对齐下的 字节/周期
+// byte 为原来的逐字节循环，word 为 64 位标量实现，rvv 为向量实现（没有 V 扩展时不测）
+#define STR_BENCH_MAX   65536
+#define STR_BENCH_BYTES (1 << 20)   // 每个组合处理的总字节数
+
+static char str_src[STR_BENCH_MAX + 16] __attribute__((aligned(64)));
+static char str_dst[STR_BENCH_MAX + 16] __attribute__((aligned(64)));
+
+enum { SB_MEMCPY, SB_MEMSET, SB_STRLEN, SB_STRCMP, SB_NOPS };
+static const char *sb_names[SB_NOPS] = { "memcpy", "memset", "strlen", "strcmp" };
+enum { SB_BYTE, SB_WORD, SB_RVV };
+
+// 逐字节参考实现：volatile 防止编译器把循环换回库函数
+static void byte_op(int op, char *d, const char *s, int n) {
+    volatile char *vd = d;
+    volatile const char *vs = s;
+    switch (op) {
+    case SB_MEMCPY: while (n--) *vd++ = *vs++; break;
+    case SB_MEMSET: while (n--) *vd++ = 0; break;
+    case SB_STRLEN: while (*vs) vs++; break;
+    case SB_STRCMP: while (*vs && *vs == *vd) { vs++; vd++; } break;
+    }
+}
+
+// 返回处理 STR_BENCH_BYTES 字节的周期数
+static uint64_t sb_run(int op, int impl, int size, int dalign, int salign) {
+    char *d = str_dst + dalign, *s = str_src + salign;
+    int iters = STR_BENCH_BYTES / size;
+    int rvv = string_use_rvv;
+    volatile uint64_t sink = 0;
+
+    // strlen/strcmp 的串长为 size - 1，两个串内容相同（比较要走到结尾）
+    memset(str_src, 'a', sizeof(str_src));
+    s[size - 1] = 0;
+    memcpy(d, s, size);
+
+    string_use_rvv = impl == SB_RVV;
+    uint64_t t0 = r_cycle();
+    for (int i = 0; i < iters; i++) {
+        if (impl == SB_BYTE) {
+            byte_op(op, d, s, size);
+            continue;
+        }
+        switch (op) {
+        case SB_MEMCPY: memcpy(d, s, size); break;
+        case SB_MEMSET: memset(d, 0, size); break;
+        case SB_STRLEN: sink += strlen(s); break;
+        case SB_STRCMP: sink += strcmp(s, d); break;
+        }
+    }
+    uint64_t t = r_cycle() - t0;
+    string_use_rvv = rvv;
+    return t ? t : 1;
+}
+
+void bench_string(void) {
+    static const int sizes[] = { 16, 256, 4096, STR_BENCH_MAX };
+    static const int aligns[][2] = { { 0, 0 }, { 3, 3 }, { 0, 5 } };   // 目的, 源
+    const char *impls[] = { "byte", "word", "rvv" };
+    int nimpl = string_use_rvv ? 3 : 2;
+
+    printf("bench_string: bytes/cycle, %d KB per case%s\n",
+           STR_BENCH_BYTES >> 10, string_use_rvv ? "" : " (no V extension)");
+    for (int op = 0; op < SB_NOPS; op++) {
+        for (int i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+            for (int a = 0; a < sizeof(aligns) / sizeof(aligns[0]); a++) {
+                char line[128];
+                int n = snprintf(line, sizeof(line), "  %-6s %5d d+%d s+%d:",
+                                 sb_names[op], sizes[i], aligns[a][0], aligns[a][1]);
+                for (int impl = 0; impl < nimpl; impl++) {
+                    uint64_t bpc = (uint64_t)STR_BENCH_BYTES * 100 /
+                                   sb_run(op, impl, sizes[i], aligns[a][0], aligns[a][1]);
+                    n += snprintf(line + n, sizeof(line) - n, "  %s %lu.%02lu",
+                                  impls[impl], bpc / 100, bpc % 100);
+                }
+                printf("%s\n", line);
+            }
+        }
+    }
+}
+
+void bench_all(void) {
+    printf("Starting benchmarks...\n");
+    bench_vdso();
+    bench_printf();
+    bench_string();
+    bench_dirlookup();
+    bench_namei();
+    dcache_dump();
+    bench_blk();
+    bench_journal();
+    bench_readahead();
+    bench_sendfile();
+    bench_pipe();
+}
+
+// ========== 基准测试套件：机器可读的输出 ==========
+// 每项一行 JSON，ns 与 cycles 都是单次操作的平均值，例如
+//   {"bench":"alloc_page","ops":10000,"ns":48,"cycles":120}
+// 其余输出都不以 '{' 开头，用 grep '^{' 即可取出结果跨提交比较
+
+static void bc_report(const char *name, int ops, struct bclock *b) {
+    printf("{\"bench\":\"%s\",\"ops\":%d,\"ns\":%lu,\"cycles\":%lu}\n",
+           name, ops, time_to_ns(b->t) / ops, b->c / ops);
+}
+
+// alloc_page / free_page：每轮连续分配一批再全部释放
+#define SUITE_PAGES 256
+
+static int suite_pages(void) {
+    static void *pages[SUITE_PAGES];
+    struct bclock ba = {0}, bf = {0};
+
+    for (int round = 0; round < BENCH_ITERS / SUITE_PAGES; round++) {
+        bc_start(&ba);
+        for (int i = 0; i < SUITE_PAGES; i++) {
+            pages[i] = alloc_page();
+        }
+        bc_stop(&ba);
+        for (int i = 0; i < SUITE_PAGES; i++) {
+            if (pages[i] == 0) {
+                printf("suite_pages: out of memory\n");
+                return -1;
+            }
+        }
+        bc_start(&bf);
+        for (int i = 0; i < SUITE_PAGES; i++) {
+            free_page(pages[i]);
+        }
+        bc_stop(&bf);
+    }
+    int ops = BENCH_ITERS / SUITE_PAGES * SUITE_PAGES;
+    bc_report("alloc_page", ops, &ba);
+    bc_report("free_page", ops, &bf);
+    return 0;
+}
+
+// map_page：在临时页表里映射连续 va（含按需分配中间页表），叶子指向内核内存，不分配物理页
+#define SUITE_MAPS 2048
+
+static int suite_map_page(void) {
+    struct bclock b = {0};
+
+    for (int round = 0; round < 4; round++) {
+        pagetable_t pt = create_pagetable();
+        if (pt == 0) {
+            printf("suite_map_page: create_pagetable failed\n");
+            return -1;
+        }
+        bc_start(&b);
+        for (int i = 0; i < SUITE_MAPS; i++) {
+            if (map_page(pt, USERBASE + (uint64_t)i * PGSIZE, KERNBASE + (uint64_t)i * PGSIZE, PTE_R) < 0) {
+                destroy_pagetable(pt);
+                return -1;
+            }
+        }
+        bc_stop(&b);
+        destroy_pagetable(pt);
+    }
+    bc_report("map_page", 4 * SUITE_MAPS, &b);
+    return 0;
+}
+
+// swtch：与一个只会切回来的上下文来回切换，不经过调度器
+static struct context sw_self, sw_peer;
+
+static void swtch_peer(void) {
+    while (1) {
+        swtch(&sw_peer, &sw_self);
+    }
+}
+
+static int suite_swtch(void) {
+    struct bclock b = {0};
+    char *stack = alloc_page();
+    if (stack == 0) return -1;
+
+    memset(&sw_peer, 0, sizeof(sw_peer));
+    sw_peer.ra = (uint64_t)swtch_peer;
+    sw_peer.sp = (uint64_t)stack + PGSIZE;
+
+    // 关中断：时钟中断不能在对端的栈上调度走
+    int intr = intr_get();
+    intr_off();
+    bc_start(&b);
+    for (int i = 0; i < BENCH_ITERS; i++) {
+        swtch(&sw_self, &sw_peer);
+    }
+    bc_stop(&b);
+    if (intr) {
+        intr_on();
+    }
+    free_page(stack);
+    bc_report("swtch", 2 * BENCH_ITERS, &b);
+    return 0;
+}
+
+// 系统调用往返：最短的 getpid
+static int suite_syscall(void) {
+    struct bclock b = {0};
+    volatile int sink = 0;
+
+    bc_start(&b);
+    for (int i = 0; i < BENCH_ITERS; i++) {
+        sink += getpid();
+    }
+    bc_stop(&b);
+    bc_report("syscall_getpid", BENCH_ITERS, &b);
+    return 0;
+}
+
+// 文件：创建、写一页、读回、关闭、删除，各阶段分别计时
+#define SUITE_FILES 256
+
+static int suite_file(void) {
+    static char page[BSIZE];
+    struct bclock bo = {0}, bw = {0}, br = {0}, bu = {0};
+    const char *path = "/bsuite";
+
+    memset(page, 'f', sizeof(page));
+    unlink(path);  // 上次运行中断时的残留
+    for (int i = 0; i < SUITE_FILES; i++) {
+        bc_start(&bo);
+        int fd = open(path, 1);
+        bc_stop(&bo);
+        if (fd < 0) {
+            printf("suite_file: create failed\n");
+            return -1;
+        }
+
+        bc_start(&bw);
+        int nw = write(fd, page, sizeof(page));
+        bc_stop(&bw);
+        bc_start(&br);
+        int nr = pread(fd, page, sizeof(page), 0);
+        bc_stop(&br);
+        close(fd);
+        if (nw != sizeof(page) || nr != sizeof(page)) {
+            printf("suite_file: short io (%d, %d)\n", nw, nr);
+            unlink(path);
+            return -1;
+        }
+
+        bc_start(&bu);
+        int r = unlink(path);
+        bc_stop(&bu);
+        if (r < 0) {
+            printf("suite_file: unlink failed\n");
+            return -1;
+        }
+    }
+    bc_report("file_open_create", SUITE_FILES, &bo);
+    bc_report("file_write_4k", SUITE_FILES, &bw);
+    bc_report("file_read_4k", SUITE_FILES, &br);
+    bc_report("file_unlink", SUITE_FILES, &bu);
+    return 0;
+}
+
+// 格式化：snprintf 只测格式化，printf 加上写入控制台环（行首不是 '{'）
+static int suite_printf(void) {
+    struct bclock bs = {0}, bp = {0};
+
+    printf_loops(&bs, &bp);
+    bc_report("snprintf", BENCH_ITERS, &bs);
+    bc_report("printf", PRINTF_BENCH_LINES, &bp);
+    return 0;
+}
+
+// 运行整个套件，返回失败的项数；rev 为构建时的 git 版本
+int bench_suite(const char *rev) {
+    static int (*const suite[])(void) = {
+        suite_pages, suite_map_page, suite_swtch, suite_syscall, suite_file, suite_printf,
+    };
+    int failed = 0;
+
+    printf("{\"suite\":\"minios\",\"rev\":\"%s\",\"timebase\":%lu,\"harts\":%d,\"mem_mb\":%lu}\n",
+           rev, vdso_page()->timebase_freq, machine.nharts,
+           (machine_ram_end() - KERNBASE) >> 20);
+    for (int i = 0; i < sizeof(suite) / sizeof(suite[0]); i++) {
+        if (suite[i]() < 0) failed++;
+    }
+
+    // 本进程在整个套件中的硬件事件计数（不可用的为 0，见 mask）
+    uint64_t c[PERF_NEVENTS];
+    int mask = perf_counts(current_proc, c, PERF_NEVENTS);
+    printf("{\"perf\":\"bench_suite\",\"mask\":%d,\"cycles\":%lu,\"instret\":%lu,\"cache_misses\":%lu,\"branch_misses\":%lu}\n",
+           mask, c[PERF_CYCLES], c[PERF_INSTRET], c[PERF_CACHE_MISSES], c[PERF_BRANCH_MISSES]);
+    printf("{\"suite\":\"minios\",\"failed\":%d}\n", failed);
+    return failed;
+}
@@ -0,0 +1,252 @@
+// kernel/blk/blkq.c
+// 块层：页缓存提交的单块 I/O 在这里合并成连续的多块请求，
+// 按块号排序（C-LOOK 电梯）后批量放入设备队列，每批只通知设备一次
+#include "blk/blk.h"
+#include "printf.h"
+#include "string.h"
+#include "proc/proc.h"
+
+struct blk_stats blk_stats;
+
+static struct blk_request rqpool[NREQ];
+static struct blk_request *rqfree;
+static struct blk_request *pending;   // 等待派发，按 start 递增
+static int inflight;                  // 已在设备中的请求数
+static int plugged;                   // > 0 时只入队不派发
+static uint head_pos;                 // 上一个派发请求的结束位置（电梯磁头）
+static int dispatching;
+
+static struct blk_request* rq_alloc(void) {
+    static int inited;
+    if (!inited) {
+        for (int i = 0; i < NREQ; i++) {
+            rqpool[i].next = rqfree;
+            rqfree = &rqpool[i];
+        }
+        inited = 1;
+    }
+    struct blk_request *rq = rqfree;
+    if (rq) {
+        rqfree = rq->next;
+    }
+    return rq;
+}
+
+static void rq_free(struct blk_request *rq) {
+    rq->next = rqfree;
+    rqfree = rq;
+    wakeup(&rqfree);
+}
+
+// 尝试把 b 并入等待队列中相邻的同向请求（尾部或头部）
+static int try_merge(struct buf *b, int write) {
+    for (struct blk_request *rq = pending; rq; rq = rq->next) {
+        if (rq->write != write || rq->nbufs >= BLK_MAX_SEGS) continue;
+
+        if (rq->start + rq->nbufs == b->blockno) {
+            rq->bufs[rq->nbufs++] = b;
+            return 1;
+        }
+        if (b->blockno + 1 == rq->start) {
+            for (int i = rq->nbufs; i > 0; i--) {
+                rq->bufs[i] = rq->bufs[i - 1];
+            }
+            rq->bufs[0] = b;
+            rq->nbufs++;
+            rq->start--;
+            return 1;
+        }
+        if (rq->start > b->blockno + 1) break;  // 队列有序，后面不会再相邻
+    }
+    return 0;
+}
+
+static void insert_sorted(struct blk_request *rq) {
+    struct blk_request **pp = &pending;
+    while (*pp && (*pp)->start < rq->start) {
+        pp = &(*pp)->next;
+    }
+    rq->next = *pp;
+    *pp = rq;
+}
+
+// 等待 b 的 I/O 完成；进程上下文中睡眠，启动阶段轮询设备
+void blk_wait(struct buf *b) {
+    int intr = intr_get();
+    intr_off();
+    while (b->io) {
+        if (current_proc) {
+            sleep(b);
+        } else if (blkdev->poll) {
+            blkdev->poll();
+        }
+    }
+    if (intr) {
+        intr_on();
+    }
+}
+
+// 异步提交：每块尽量并入已有请求，否则新建请求；不等待完成
+void blk_submit(struct buf **bufs, int n, int write) {
+    int intr = intr_get();
+    intr_off();
+
+    for (int i = 0; i < n; i++) {
+        struct buf *b = bufs[i];
+        b->io = 1;
+        blk_stats.bios++;
+        if (try_merge(b, write)) {
+            blk_stats.merges++;
+            continue;
+        }
+
+        struct blk_request *rq;
+        while ((rq = rq_alloc()) == 0) {
+            // 请求耗尽：先派发已有的，等待完成后释放
+            plugged = 0;
+            blk_dispatch();
+            if (current_proc) {
+                sleep(&rqfree);
+            } else if (blkdev->poll) {
+                blkdev->poll();
+            }
+        }
+        rq->write = write;
+        rq->start = b->blockno;
+        rq->nbufs = 1;
+        rq->bufs[0] = b;
+        rq->t_queue = r_time();
+        insert_sorted(rq);
+    }
+
+    if (!plugged) {
+        blk_dispatch();
+    }
+    if (intr) {
+        intr_on();
+    }
+}
+
+// 同步读/写
+void blk_rw(struct buf **bufs, int n, int write) {
+    blk_submit(bufs, n, write);
+    for (int i = 0; i < n; i++) {
+        blk_wait(bufs[i]);
+    }
+}
+
+// 插入期间暂停派发，让相邻的块有机会合并（bsync 一次写回大量脏块时使用）
+void blk_plug(void) {
+    plugged++;
+}
+
+void blk_unplug(void) {
+    int intr = intr_get();
+    intr_off();
+    if (plugged > 0 && --plugged == 0) {
+        blk_dispatch();
+    }
+    if (intr) {
+        intr_on();
+    }
+}
+
+// C-LOOK：从磁头位置向块号增大的方向派发，到头后回到最小块号
+static struct blk_request* pick_next(void) {
+    struct blk_request **pp = &pending;
+    while (*pp && (*pp)->start < head_pos) {
+        pp = &(*pp)->next;
+    }
+    if (*pp == 0) {
+        pp = &pending;
+    }
+    return *pp;
+}
+
+static void unlink_pending(struct blk_request *rq) {
+    for (struct blk_request **pp = &pending; *pp; pp = &(*pp)->next) {
+        if (*pp == rq) {
+            *pp = rq->next;
+            return;
+        }
+    }
+}
+
+// 把等待队列中的请求按电梯顺序放入设备，直到设备队列满；最后统一通知
+// 调用时中断已关闭；完成中断中也会调用，用 dispatching 防止重入
+void blk_dispatch(void) {
+    if (dispatching || plugged) return;
+    dispatching = 1;
+
+    int queued = 0;
+    struct blk_request *rq;
+    while ((rq = pick_next()) != 0) {
+        unlink_pending(rq);
+        inflight++;
+        if (blkdev->queue_rq(rq) < 0) {
+            inflight--;
+            insert_sorted(rq);  // 设备队列已满，等完成中断再派发
+            break;
+        }
+        head_pos = rq->start + rq->nbufs;
+        blk_stats.requests++;
+        blk_stats.depth_sum += inflight;
+        if (inflight > blk_stats.depth_max) {
+            blk_stats.depth_max = inflight;
+        }
+        queued++;
+    }
+    if (queued && blkdev->kick) {
+        blkdev->kick();
+        blk_stats.kicks++;
+    }
+
+    dispatching = 0;
+}
+
+// 驱动在请求完成时调用（中断上下文或同步设备的 queue_rq 中）
+void blk_complete(struct blk_request *rq, int ok) {
+    uint64_t lat = r_time() - rq->t_queue;
+    blk_stats.lat_total += lat;
+    if (lat > blk_stats.lat_max) {
+        blk_stats.lat_max = lat;
+    }
+    uint64_t us = lat * 1000000 / TIMEBASE_FREQ;
+    int bucket = 0;
+    while (us > 1 && bucket < 15) {
+        us >>= 1;
+        bucket++;
+    }
+    blk_stats.lat_hist[bucket]++;
+    if (!ok) {
+        blk_stats.errors++;
+    }
+
+    for (int i = 0; i < rq->nbufs; i++) {
+        struct buf *b = rq->bufs[i];
+        b->io = 0;
+        wakeup(b);
+        if (b->readahead) {
+            breadahead_done(b, ok);  // 预读的块没有进程等待，在这里释放
+        }
+    }
+    inflight--;
+    rq_free(rq);
+}
+
+void blk_stats_dump(void) {
+    uint64_t req = blk_stats.requests ? blk_stats.requests : 1;
+    printf("blk: %d blocks -> %d requests (%d merged), %d kicks, %d errors\n",
+           (int)blk_stats.bios, (int)blk_stats.requests, (int)blk_stats.merges,
+           (int)blk_stats.kicks, (int)blk_stats.errors);
+    printf("blk: latency avg %d us, max %d us; queue depth avg %d.%d, max %d\n",
+           (int)(blk_stats.lat_total * 1000000 / TIMEBASE_FREQ / req),
+           (int)(blk_stats.lat_max * 1000000 / TIMEBASE_FREQ),
+           (int)(blk_stats.depth_sum / req), (int)(blk_stats.depth_sum * 10 / req % 10),
+           blk_stats.depth_max);
+    for (int i = 0; i < 16; i++) {
+        if (blk_stats.lat_hist[i]) {
+            printf("  [%d, %d) us: %d\n", i ? 1 << i : 0, 2 << i, blk_stats.lat_hist[i]);
+        }
+    }
+}
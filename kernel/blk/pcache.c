@@ -0,0 +1,305 @@
+// kernel/blk/pcache.c
+// 页缓存：文件系统与块设备之间的唯一数据通道
+// 命中的块直接从内存返回；写只标记脏页，由回写线程、bsync 或淘汰时批量写回
+// 顺序读由文件层提交异步预读（breadahead），读到时块已在缓存或正在传输
+#include "blk/blk.h"
+#include "printf.h"
+#include "string.h"
+#include "mm/pmm.h"
+#include "proc/proc.h"
+
+struct blkdev *blkdev;
+struct pcache_stats pcache_stats;
+
+static struct buf bufs[NBUF];
+static struct buf *bhash[BUF_HASH];
+static struct buf lru;   // 哨兵
+static int ndirty;       // 脏块数（近似，bsync 后重新统计）
+static int flush_age;    // 距上次定时回写的时钟中断数
+static int flush_due;
+
+static void lru_remove(struct buf *b) {
+    b->prev->next = b->next;
+    b->next->prev = b->prev;
+}
+
+static void lru_push_front(struct buf *b) {
+    b->next = lru.next;
+    b->prev = &lru;
+    lru.next->prev = b;
+    lru.next = b;
+}
+
+void blk_init(void) {
+    lru.next = lru.prev = &lru;
+    for (int i = 0; i < NBUF; i++) {
+        bufs[i].blockno = ~0U;
+        lru_push_front(&bufs[i]);
+    }
+
+    if (virtio_blk_init() < 0) {
+        ramdisk_init();
+    }
+    printf("blk_init: %s, %d blocks, %d-block page cache\n",
+           blkdev->name, (int)blkdev->nblocks, NBUF);
+}
+
+static struct buf** bucket(uint blockno) {
+    return &bhash[blockno % BUF_HASH];
+}
+
+static void unhash(struct buf *b) {
+    for (struct buf **pp = bucket(b->blockno); *pp; pp = &(*pp)->hnext) {
+        if (*pp == b) {
+            *pp = b->hnext;
+            return;
+        }
+    }
+}
+
+// 取得 blockno 的缓存块并独占它（busy）；未命中时复用最久未使用的空闲块
+static struct buf* bget(uint blockno) {
+    struct buf *b;
+    int intr = intr_get();
+    intr_off();
+
+again:
+    for (b = *bucket(blockno); b; b = b->hnext) {
+        if (b->blockno == blockno) {
+            b->refcnt++;
+            while (b->busy) {
+                sleep(b);
+            }
+            b->busy = 1;
+            goto out;
+        }
+    }
+
+    for (b = lru.prev; b != &lru; b = b->prev) {
+        if (b->refcnt == 0) break;
+    }
+    if (b == &lru) {
+        panic("bget: no free buffers");
+    }
+    if (b->dirty) {
+        // 写回时会睡眠，期间缓存可能变化，回来后重新查找
+        bsync();
+        goto again;
+    }
+    if (b->data == 0 && (b->data = alloc_page()) == 0) {
+        panic("bget: out of memory");
+    }
+
+    unhash(b);
+    b->blockno = blockno;
+    b->hnext = *bucket(blockno);
+    *bucket(blockno) = b;
+    b->valid = 0;
+    b->prefetched = 0;
+    b->refcnt = 1;
+    b->busy = 1;
+
+out:
+    if (intr) {
+        intr_on();
+    }
+    return b;
+}
+
+struct buf* bread(uint blockno) {
+    struct buf *b = bget(blockno);
+    if (b->valid) {
+        pcache_stats.hits++;
+        if (b->prefetched) {
+            pcache_stats.ra_hits++;
+            b->prefetched = 0;
+        }
+    } else {
+        pcache_stats.misses++;
+        blk_rw(&b, 1, 0);
+        b->valid = 1;
+    }
+    return b;
+}
+
+// 取得一个将被整块覆盖的块，不从设备读取
+struct buf* bget_zero(uint blockno) {
+    struct buf *b = bget(blockno);
+    page_zero(b->data);
+    b->valid = 1;
+    return b;
+}
+
+// 写回式：只标记为脏，脏块积累到 DIRTY_HIGH 时唤醒回写线程
+void bwrite(struct buf *b) {
+    if (!b->dirty) {
+        b->dirty = 1;
+        if (++ndirty >= DIRTY_HIGH) {
+            wakeup(&ndirty);
+        }
+    }
+}
+
+// 异步预读：未缓存的块取一个空闲缓存块提交读请求后立即返回
+// 块保持 busy 直到完成中断调用 breadahead_done，其间 bread 会等待它
+// 先取齐缓存块再一次提交：bget 可能要 bsync，不能在 plug 期间睡眠
+void breadahead(uint *blocks, int n) {
+    struct buf *batch[BLK_MAX_SEGS];
+    int nb = 0;
+    int intr = intr_get();
+    intr_off();
+
+    for (int i = 0; i < n; i++) {
+        struct buf *b;
+        for (b = *bucket(blocks[i]); b; b = b->hnext) {
+            if (b->blockno == blocks[i]) break;
+        }
+        if (b == 0) {
+            b = bget(blocks[i]);
+            if (b->valid) {
+                brelse(b);  // bget 中写回脏块时睡眠过，块已被别人读入
+            } else {
+                b->readahead = 1;
+                batch[nb++] = b;
+            }
+        }
+        if (nb == BLK_MAX_SEGS || (nb > 0 && i == n - 1)) {
+            blk_submit(batch, nb, 0);
+            pcache_stats.ra_blocks += nb;
+            nb = 0;
+        }
+    }
+
+    if (intr) {
+        intr_on();
+    }
+}
+
+// 预读完成（中断上下文）
+void breadahead_done(struct buf *b, int ok) {
+    b->readahead = 0;
+    b->valid = ok;
+    b->prefetched = ok;
+    brelse(b);
+}
+
+void brelse(struct buf *b) {
+    int intr = intr_get();
+    intr_off();
+    b->busy = 0;
+    if (--b->refcnt == 0) {
+        lru_remove(b);
+        lru_push_front(b);
+    }
+    wakeup(b);
+    if (intr) {
+        intr_on();
+    }
+}
+
+// 日志钉住的块多持有一个引用，不会被淘汰
+void bpin(struct buf *b) {
+    int intr = intr_get();
+    intr_off();
+    b->refcnt++;
+    b->pinned = 1;
+    if (intr) {
+        intr_on();
+    }
+}
+
+void bunpin(struct buf *b) {
+    int intr = intr_get();
+    intr_off();
+    b->pinned = 0;
+    if (--b->refcnt == 0) {
+        lru_remove(b);
+        lru_push_front(b);
+    }
+    if (intr) {
+        intr_on();
+    }
+}
+
+// 把所有未被持有的脏块写回设备（日志中的块由提交写回）
+// 先全部放入块层队列再一次派发，相邻块由块层合并成大请求
+void bsync(void) {
+    static int syncing;
+    int intr = intr_get();
+    intr_off();
+
+    // flushing 标记由本次 bsync 独占，同一时刻只允许一个
+    while (syncing) {
+        sleep(&syncing);
+    }
+    syncing = 1;
+
+    int n = 0;
+    blk_plug();
+    for (int i = 0; i < NBUF; i++) {
+        struct buf *b = &bufs[i];
+        if (b->dirty && !b->busy && !b->pinned) {
+            b->busy = 1;
+            b->refcnt++;
+            b->flushing = 1;
+            blk_submit(&b, 1, 1);
+            n++;
+        }
+    }
+    blk_unplug();
+
+    for (int i = 0; i < NBUF; i++) {
+        struct buf *b = &bufs[i];
+        if (b->flushing) {
+            blk_wait(b);
+            b->flushing = 0;
+            b->dirty = 0;
+            brelse(b);
+        }
+    }
+    pcache_stats.writebacks += n;
+    ndirty = 0;
+    for (int i = 0; i < NBUF; i++) {
+        ndirty += bufs[i].dirty;
+    }
+    syncing = 0;
+    wakeup(&syncing);
+
+    if (intr) {
+        intr_on();
+    }
+}
+
+// 时钟中断中调用：定时唤醒回写线程
+void pcache_tick(void) {
+    if (++flush_age >= FLUSH_TICKS) {
+        flush_age = 0;
+        if (ndirty) {
+            flush_due = 1;
+            wakeup(&ndirty);
+        }
+    }
+}
+
+// 回写线程：把分散的写聚成大批次，bsync 按块号合并成多块请求
+// 写入者只标记脏页，不必等设备
+void bflush_task(void) {
+    int stalled = 0;
+
+    intr_off();
+    while (1) {
+        while ((stalled || ndirty < DIRTY_HIGH) && !flush_due) {
+            sleep(&ndirty);
+        }
+        flush_due = 0;
+
+        uint64_t before = pcache_stats.writebacks;
+        bsync();
+        // 剩下的脏块都被占用（持有中或在日志里），等下一个周期
+        stalled = pcache_stats.writebacks == before;
+        if (!stalled) {
+            pcache_stats.flushes++;
+            pcache_stats.flush_blocks += pcache_stats.writebacks - before;
+        }
+    }
+}
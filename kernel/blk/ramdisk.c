@@ -0,0 +1,50 @@
+// kernel/blk/ramdisk.c
+// 没有 virtio 磁盘时的后备块设备：块按需分配物理页，内容不跨重启保留
+#include "blk/blk.h"
+#include "printf.h"
+#include "string.h"
+#include "mm/pmm.h"
+
+#define RAMDISK_BLOCKS 4096   // 16MB
+
+static char *rd_blocks[RAMDISK_BLOCKS];
+
+static int ramdisk_queue_rq(struct blk_request *rq);
+
+static struct blkdev ramdisk_dev = {
+    .name = "ramdisk",
+    .nblocks = RAMDISK_BLOCKS,
+    .queue_rq = ramdisk_queue_rq,
+};
+
+// 同步完成：返回前已调用 blk_complete
+static int ramdisk_queue_rq(struct blk_request *rq) {
+    int ok = 1;
+    for (int i = 0; i < rq->nbufs; i++) {
+        struct buf *b = rq->bufs[i];
+        char **blk = &rd_blocks[b->blockno];
+
+        if (b->blockno >= RAMDISK_BLOCKS) {
+            printf("ramdisk: block %d out of range\n", b->blockno);
+            ok = 0;
+        } else if (rq->write) {
+            if (*blk == 0 && (*blk = alloc_page()) == 0) {
+                printf("ramdisk: out of memory\n");
+                ok = 0;
+            } else {
+                memcpy(*blk, b->data, BSIZE);
+            }
+        } else if (*blk) {
+            memcpy(b->data, *blk, BSIZE);
+        } else {
+            memset(b->data, 0, BSIZE);  // 从未写过的块读出为 0
+        }
+    }
+    blk_complete(rq, ok);
+    return 0;
+}
+
+void ramdisk_init(void) {
+    blkdev = &ramdisk_dev;
+    printf("ramdisk_init: no virtio disk, using %d-block ramdisk\n", RAMDISK_BLOCKS);
+}
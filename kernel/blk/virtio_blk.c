@@ -0,0 +1,222 @@
+// kernel/blk/virtio_blk.c
+// QEMU virt 平台的 virtio-blk（MMIO version 2）驱动
+// 块层的一个请求是一条描述符链：请求头 + 每块一个数据段 + 状态字节
+// 一批请求全部放入 avail 环后只通知设备一次，完成由中断（启动阶段为轮询）回收
+#include "blk/blk.h"
+#include "blk/virtio.h"
+#include "trap/plic.h"
+#include "printf.h"
+#include "string.h"
+#include "mm/pmm.h"
+
+#define R(r) ((volatile uint32_t*)(disk.base + (r)))
+
+static struct {
+    uint64_t base;
+    struct virtq_desc *desc;
+    struct virtq_avail *avail;
+    struct virtq_used *used;
+
+    char free[VIRTIO_NUM];     // 描述符是否空闲
+    int nfree;
+    uint16_t avail_idx;        // 已放入但可能尚未发布的 avail 位置
+    uint16_t used_idx;         // 已回收到的 used 环位置
+
+    // 以请求链首描述符为下标
+    struct {
+        struct blk_request *rq;
+        uint8_t status;
+    } info[VIRTIO_NUM];
+    struct virtio_blk_req ops[VIRTIO_NUM];
+} disk;
+
+int virtio_blk_irq;
+
+static int virtio_blk_queue_rq(struct blk_request *rq);
+static void virtio_blk_kick(void);
+
+static struct blkdev virtio_dev = {
+    .name = "virtio-blk",
+    .queue_rq = virtio_blk_queue_rq,
+    .kick = virtio_blk_kick,
+    .poll = virtio_blk_intr,
+};
+
+static int alloc_desc(void) {
+    for (int i = 0; i < VIRTIO_NUM; i++) {
+        if (disk.free[i]) {
+            disk.free[i] = 0;
+            disk.nfree--;
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void free_chain(int i) {
+    while (1) {
+        int flags = disk.desc[i].flags;
+        int next = disk.desc[i].next;
+        memset(&disk.desc[i], 0, sizeof(disk.desc[i]));
+        disk.free[i] = 1;
+        disk.nfree++;
+        if (!(flags & VRING_DESC_F_NEXT)) break;
+        i = next;
+    }
+}
+
+// 探测设备树列出的 virtio MMIO 槽位，初始化第一个块设备
+int virtio_blk_init(void) {
+    int slot;
+    for (slot = 0; slot < machine.nvirtio; slot++) {
+        disk.base = machine.virtio[slot].base;
+        if (*R(VIRTIO_MMIO_MAGIC_VALUE) == 0x74726976 &&
+            *R(VIRTIO_MMIO_VERSION) == 2 &&
+            *R(VIRTIO_MMIO_DEVICE_ID) == 2) {
+            break;
+        }
+    }
+    if (slot == machine.nvirtio) {
+        return -1;
+    }
+
+    uint32_t status = 0;
+    *R(VIRTIO_MMIO_STATUS) = status;  // 复位
+    status |= VIRTIO_STATUS_ACKNOWLEDGE;
+    *R(VIRTIO_MMIO_STATUS) = status;
+    status |= VIRTIO_STATUS_DRIVER;
+    *R(VIRTIO_MMIO_STATUS) = status;
+
+    uint32_t features = *R(VIRTIO_MMIO_DEVICE_FEATURES);
+    features &= ~(1U << VIRTIO_BLK_F_RO);
+    features &= ~(1U << VIRTIO_BLK_F_SCSI);
+    features &= ~(1U << VIRTIO_BLK_F_CONFIG_WCE);
+    features &= ~(1U << VIRTIO_BLK_F_MQ);
+    features &= ~(1U << VIRTIO_F_ANY_LAYOUT);
+    features &= ~(1U << VIRTIO_RING_F_EVENT_IDX);
+    features &= ~(1U << VIRTIO_RING_F_INDIRECT_DESC);
+    *R(VIRTIO_MMIO_DRIVER_FEATURES) = features;
+
+    status |= VIRTIO_STATUS_FEATURES_OK;
+    *R(VIRTIO_MMIO_STATUS) = status;
+    if (!(*R(VIRTIO_MMIO_STATUS) & VIRTIO_STATUS_FEATURES_OK)) {
+        printf("virtio_blk_init: FEATURES_OK not accepted\n");
+        return -1;
+    }
+
+    *R(VIRTIO_MMIO_QUEUE_SEL) = 0;
+    if (*R(VIRTIO_MMIO_QUEUE_READY) || *R(VIRTIO_MMIO_QUEUE_NUM_MAX) < VIRTIO_NUM) {
+        printf("virtio_blk_init: queue 0 unusable\n");
+        return -1;
+    }
+
+    disk.desc = alloc_page();
+    disk.avail = alloc_page();
+    disk.used = alloc_page();
+    if (!disk.desc || !disk.avail || !disk.used) {
+        printf("virtio_blk_init: out of memory\n");
+        return -1;
+    }
+    page_zero(disk.desc);
+    page_zero(disk.avail);
+    page_zero(disk.used);
+
+    *R(VIRTIO_MMIO_QUEUE_NUM) = VIRTIO_NUM;
+    *R(VIRTIO_MMIO_QUEUE_DESC_LOW) = (uint64_t)disk.desc;
+    *R(VIRTIO_MMIO_QUEUE_DESC_HIGH) = (uint64_t)disk.desc >> 32;
+    *R(VIRTIO_MMIO_DRIVER_DESC_LOW) = (uint64_t)disk.avail;
+    *R(VIRTIO_MMIO_DRIVER_DESC_HIGH) = (uint64_t)disk.avail >> 32;
+    *R(VIRTIO_MMIO_DEVICE_DESC_LOW) = (uint64_t)disk.used;
+    *R(VIRTIO_MMIO_DEVICE_DESC_HIGH) = (uint64_t)disk.used >> 32;
+    *R(VIRTIO_MMIO_QUEUE_READY) = 1;
+
+    for (int i = 0; i < VIRTIO_NUM; i++) {
+        disk.free[i] = 1;
+    }
+    disk.nfree = VIRTIO_NUM;
+
+    status |= VIRTIO_STATUS_DRIVER_OK;
+    *R(VIRTIO_MMIO_STATUS) = status;
+
+    uint64_t sectors = *(volatile uint64_t*)(disk.base + VIRTIO_MMIO_CONFIG);
+    virtio_dev.nblocks = sectors / (BSIZE / SECTOR_SIZE);
+    virtio_blk_irq = machine.virtio[slot].irq;
+    plic_enable(virtio_blk_irq);
+    blkdev = &virtio_dev;
+
+    printf("virtio_blk_init: slot %d, irq %d, %d blocks\n",
+           slot, virtio_blk_irq, (int)virtio_dev.nblocks);
+    return 0;
+}
+
+// 把请求放入 avail 环（不通知设备）；描述符不够时返回 -1，由块层稍后重试
+static int virtio_blk_queue_rq(struct blk_request *rq) {
+    int need = rq->nbufs + 2;
+    if (disk.nfree < need) return -1;
+
+    int head = alloc_desc();
+    struct virtio_blk_req *req = &disk.ops[head];
+    req->type = rq->write ? VIRTIO_BLK_T_OUT : VIRTIO_BLK_T_IN;
+    req->reserved = 0;
+    req->sector = (uint64_t)rq->start * (BSIZE / SECTOR_SIZE);
+
+    disk.desc[head].addr = (uint64_t)req;
+    disk.desc[head].len = sizeof(*req);
+    disk.desc[head].flags = VRING_DESC_F_NEXT;
+
+    int prev = head;
+    for (int i = 0; i < rq->nbufs; i++) {
+        int d = alloc_desc();
+        disk.desc[prev].next = d;
+        disk.desc[d].addr = (uint64_t)rq->bufs[i]->data;
+        disk.desc[d].len = BSIZE;
+        disk.desc[d].flags = (rq->write ? 0 : VRING_DESC_F_WRITE) | VRING_DESC_F_NEXT;
+        prev = d;
+    }
+
+    int st = alloc_desc();
+    disk.desc[prev].next = st;
+    disk.info[head].status = 0xff;  // 设备成功时写 0
+    disk.info[head].rq = rq;
+    disk.desc[st].addr = (uint64_t)&disk.info[head].status;
+    disk.desc[st].len = 1;
+    disk.desc[st].flags = VRING_DESC_F_WRITE;
+    disk.desc[st].next = 0;
+
+    disk.avail->ring[disk.avail_idx % VIRTIO_NUM] = head;
+    disk.avail_idx++;
+    return 0;
+}
+
+// 发布已放入的请求并通知设备（一批只写一次 QUEUE_NOTIFY）
+static void virtio_blk_kick(void) {
+    __sync_synchronize();
+    disk.avail->idx = disk.avail_idx;
+    __sync_synchronize();
+    *R(VIRTIO_MMIO_QUEUE_NOTIFY) = 0;
+}
+
+// 完成中断：回收 used 环中的请求并唤醒等待者（也用作启动阶段的轮询）
+void virtio_blk_intr(void) {
+    *R(VIRTIO_MMIO_INTERRUPT_ACK) = *R(VIRTIO_MMIO_INTERRUPT_STATUS) & 0x3;
+    __sync_synchronize();
+
+    while (disk.used_idx != disk.used->idx) {
+        __sync_synchronize();
+        int id = disk.used->ring[disk.used_idx % VIRTIO_NUM].id;
+        struct blk_request *rq = disk.info[id].rq;
+        int ok = disk.info[id].status == 0;
+
+        if (!ok) {
+            printf("virtio_blk: blocks %d+%d I/O error %d\n",
+                   rq->start, rq->nbufs, disk.info[id].status);
+        }
+        disk.info[id].rq = 0;
+        free_chain(id);
+        disk.used_idx++;
+        blk_complete(rq, ok);
+    }
+
+    // 描述符已释放，继续派发等待中的请求
+    blk_dispatch();
+}
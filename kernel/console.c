@@ -1,26 +1,138 @@
 // kernel/console.c
+// 控制台输出环：多个生产者（printf、sys_write、中断处理程序）无锁追加，
+// 单个 drainer 每次把 UART 发送 FIFO 填满，剩余部分由 THR 空中断继续发送
+#include "riscv.h"
 #include "console.h"
-#include "uart.h"  // ✅ 确保包含 uart.h，因为 console_putc 调用 uart_putc
+#include "uart.h"
 #include "printf.h"
+#include "string.h"
+
+#define CONS_BUF  8192              // 2 的幂
+#define CONS_MASK (CONS_BUF - 1)
+
+static char cons_buf[CONS_BUF];
+static uint8_t cons_ready[CONS_BUF]; // 生产者复制完成后置 1，drainer 发送后清 0
+static uint64_t cons_tail;           // 已预留到的位置，生产者用 CAS 推进
+static uint64_t cons_head;           // 已送入 UART 的位置，只由 drainer 推进
+static int cons_draining;            // drainer 互斥标志
+static int cons_panicking;           // panic 后绕过环直接同步输出
+static uint64_t cons_dropped;        // 环满且无法排空时丢弃的字节数
+
+static int slot_ready(uint64_t pos) {
+    return __atomic_load_n(&cons_ready[pos & CONS_MASK], __ATOMIC_ACQUIRE);
+}
+
+// 向 FIFO 写入最多 UART_FIFO 个字节（\n 展开为 \r\n 占两个位置）
+// 遇到尚未提交的槽位就停下：被打断的生产者恢复后会再触发一次排空
+static void drain_fifo(void) {
+    uint64_t h = cons_head;
+    int room = UART_FIFO;
+    while (room > 0 && slot_ready(h)) {
+        char c = cons_buf[h & CONS_MASK];
+        if (c == '\n') {
+            if (room < 2) break;
+            uart_tx('\r');
+            uart_tx('\n');
+            room -= 2;
+        } else {
+            uart_tx(c);
+            room--;
+        }
+        __atomic_store_n(&cons_ready[h & CONS_MASK], 0, __ATOMIC_RELAXED);
+        h++;
+    }
+    __atomic_store_n(&cons_head, h, __ATOMIC_RELEASE);
+}
+
+// 一次排空：sync 为 0 时 FIFO 未空就交给中断，否则忙等直到已提交的字节全部发出
+static void drain(int sync) {
+    int intr = intr_get();
+    intr_off();
+    if (__atomic_exchange_n(&cons_draining, 1, __ATOMIC_ACQUIRE) == 0) {
+        while (slot_ready(cons_head)) {
+            if (!uart_tx_ready()) {
+                if (!sync) break;
+                continue;
+            }
+            drain_fifo();
+            if (!sync) break;
+        }
+        uart_tx_intr(slot_ready(cons_head));
+        __atomic_store_n(&cons_draining, 0, __ATOMIC_RELEASE);
+    }
+    if (intr) {
+        intr_on();
+    }
+}
+
+// 生产者提交后调用，UART 中断处理程序也调用这里
+void console_drain(void) {
+    drain(0);
+}
+
+// 同步发送所有已提交的字节（panic 与环满时使用）
+void console_flush(void) {
+    drain(1);
+}
+
+// 追加 n 字节：CAS 预留一段区间，复制后逐槽标记为已提交
+void console_write(const char *s, int n) {
+    if (__atomic_load_n(&cons_panicking, __ATOMIC_RELAXED)) {
+        for (int i = 0; i < n; i++) {
+            uart_putc(s[i]);
+        }
+        return;
+    }
+
+    while (n > 0) {
+        uint64_t t = __atomic_load_n(&cons_tail, __ATOMIC_RELAXED);
+        uint64_t h = __atomic_load_n(&cons_head, __ATOMIC_ACQUIRE);
+        uint64_t space = CONS_BUF - (t - h);
+        if (space == 0) {
+            // 环头是被我们打断的生产者尚未提交的数据：等不到它，只能丢弃
+            if (!slot_ready(h)) {
+                __atomic_fetch_add(&cons_dropped, n, __ATOMIC_RELAXED);
+                return;
+            }
+            console_flush();
+            continue;
+        }
+        uint64_t m = (uint64_t)n < space ? (uint64_t)n : space;
+        if (!__atomic_compare_exchange_n(&cons_tail, &t, t + m, 0,
+                                         __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+            continue;
+        }
+        for (uint64_t i = 0; i < m; i++) {
+            cons_buf[(t + i) & CONS_MASK] = s[i];
+        }
+        for (uint64_t i = 0; i < m; i++) {
+            __atomic_store_n(&cons_ready[(t + i) & CONS_MASK], 1, __ATOMIC_RELEASE);
+        }
+        s += m;
+        n -= m;
+    }
+    console_drain();
+}
+
+// 进入 panic：先把环里已有的输出同步发完，之后的输出不再经过环
+void console_panic(void) {
+    __atomic_store_n(&cons_panicking, 1, __ATOMIC_RELAXED);
+    console_flush();
+}
+
+uint64_t console_dropped(void) {
+    return __atomic_load_n(&cons_dropped, __ATOMIC_RELAXED);
+}
 
 void console_putc(char c) {
-    uart_putc(c);
+    console_write(&c, 1);
 }
 
 void console_puts(const char *s) {
     if (s == 0) {
-        console_putc('(');
-        console_putc('n');
-        console_putc('u');
-        console_putc('l');
-        console_putc('l');
-        console_putc(')');
-        return;
-    }
-    while (*s) {
-        console_putc(*s);
-        s++;
+        s = "(null)";
     }
+    console_write(s, strlen(s));
 }
 
 // 清屏 + 光标归位
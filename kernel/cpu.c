@@ -0,0 +1,55 @@
+// kernel/cpu.c
+#include "riscv.h"
+#include "cpu.h"
+#include "string.h"
+#include "printf.h"
+
+volatile int cpu_probing;
+int cpu_mmode;
+
+// V：没有向量单元时 sstatus.VS 只读为 0；置为 Initial 后内核即可使用向量寄存器
+static int probe_v(void) {
+    w_sstatus(r_sstatus() | SSTATUS_VS_INITIAL);
+    return (r_sstatus() & SSTATUS_VS) != 0;
+}
+
+// Zicboz：没有寄存器报告，直接执行一次 cbo.zero
+// 扩展不存在或 M 模式固件没有打开 menvcfg.CBZE 时都是非法指令
+static int probe_zicboz(void) {
+    static char block[CBO_BLOCK] __attribute__((aligned(CBO_BLOCK)));
+
+    memset(block, 0xff, sizeof(block));
+    cpu_probing = 1;
+    cbo_zero(block);
+    int ok = cpu_probing == 1 && block[0] == 0 && block[CBO_BLOCK - 1] == 0;
+    cpu_probing = 0;
+    return ok;
+}
+
+// 运行在 M 模式（-bios none）：mhartid 可读，下面没有 SBI 固件，ecall 会陷入未设置的 mtvec
+// 在 S 模式读 mhartid 是非法指令，由 kerneltrap 跳过；M 模式下不会陷入
+static int probe_mmode(void) {
+    uint64_t x;
+    cpu_probing = 1;
+    asm volatile("csrr %0, mhartid" : "=r" (x));
+    int ok = cpu_probing == 1;
+    cpu_probing = 0;
+    return ok;
+}
+
+// 需要在 trap_init 之后调用
+void cpu_probe(void) {
+    cpu_mmode = probe_mmode();
+    string_use_rvv = probe_v();
+    string_use_cboz = probe_zicboz();
+
+    if (string_use_rvv) {
+        uint64_t vlenb;
+        asm volatile("csrr %0, 0xc22" : "=r" (vlenb));   // vlenb
+        printf("cpu_probe: V present, VLEN=%d bits, using vector string ops\n", (int)vlenb * 8);
+    } else {
+        printf("cpu_probe: no V, using word-at-a-time string ops\n");
+    }
+    printf("cpu_probe: Zicboz %s\n", string_use_cboz ? "present, page_zero uses cbo.zero" : "absent");
+    printf("cpu_probe: running in %s\n", cpu_mmode ? "M mode, no SBI" : "S mode under SBI firmware");
+}
@@ -0,0 +1,143 @@
+// kernel/dcache.c
+// 目录项缓存：命中时路径解析不再读取目录内容
+// 固定 NDCACHE 项，按 (父目录, 名字哈希) 散列，满了按 LRU 淘汰
+#include "dcache.h"
+#include "fs.h"
+#include "printf.h"
+#include "string.h"
+
+struct dentry {
+    uint parent;          // 父目录 inum，0 表示空闲
+    uint hash;
+    uint inum;            // 0 表示负缓存
+    char name[MAX_FILENAME];
+    struct dentry *hnext;
+    struct dentry *prev;  // LRU 链表，表头是最近使用的
+    struct dentry *next;
+};
+
+static struct dentry dentries[NDCACHE];
+static struct dentry *dc_hash[DC_HASH];
+static struct dentry lru;   // 哨兵
+struct dcache_stats dcache_stats;
+
+static struct dentry** dc_bucket(uint parent, uint hash) {
+    return &dc_hash[(hash ^ parent * 2654435761U) % DC_HASH];
+}
+
+static void lru_remove(struct dentry *d) {
+    d->prev->next = d->next;
+    d->next->prev = d->prev;
+}
+
+static void lru_push_front(struct dentry *d) {
+    d->next = lru.next;
+    d->prev = &lru;
+    lru.next->prev = d;
+    lru.next = d;
+}
+
+static void lru_push_back(struct dentry *d) {
+    d->prev = lru.prev;
+    d->next = &lru;
+    lru.prev->next = d;
+    lru.prev = d;
+}
+
+// 从散列链摘下并放到 LRU 末尾，下次分配优先复用
+static void dc_drop(struct dentry *d) {
+    struct dentry **pp = dc_bucket(d->parent, d->hash);
+    for (; *pp; pp = &(*pp)->hnext) {
+        if (*pp == d) {
+            *pp = d->hnext;
+            break;
+        }
+    }
+    d->parent = 0;
+    lru_remove(d);
+    lru_push_back(d);
+}
+
+static struct dentry* dc_find(uint parent, const char *name, uint hash) {
+    for (struct dentry *d = *dc_bucket(parent, hash); d; d = d->hnext) {
+        if (d->parent == parent && d->hash == hash && strcmp(d->name, name) == 0) {
+            return d;
+        }
+    }
+    return 0;
+}
+
+void dcache_init(void) {
+    lru.next = lru.prev = &lru;
+    for (int i = 0; i < NDCACHE; i++) {
+        dentries[i].parent = 0;
+        lru_push_back(&dentries[i]);
+    }
+}
+
+// 命中返回 1 并通过 inum 返回结果（0 表示已知不存在），未命中返回 0
+int dcache_lookup(uint parent, const char *name, uint hash, uint *inum) {
+    struct dentry *d = dc_find(parent, name, hash);
+    if (d == 0) {
+        dcache_stats.misses++;
+        return 0;
+    }
+    if (d->inum) {
+        dcache_stats.hits++;
+    } else {
+        dcache_stats.neg_hits++;
+    }
+    lru_remove(d);
+    lru_push_front(d);
+    *inum = d->inum;
+    return 1;
+}
+
+void dcache_insert(uint parent, const char *name, uint hash, uint inum) {
+    if (strlen(name) >= MAX_FILENAME) return;
+
+    struct dentry *d = dc_find(parent, name, hash);
+    if (d == 0) {
+        d = lru.prev;  // 最久未使用
+        if (d->parent) {
+            dcache_stats.evictions++;
+            dc_drop(d);
+        }
+        d->parent = parent;
+        d->hash = hash;
+        strcpy(d->name, name);
+        struct dentry **b = dc_bucket(parent, hash);
+        d->hnext = *b;
+        *b = d;
+    }
+    d->inum = inum;
+    lru_remove(d);
+    lru_push_front(d);
+}
+
+void dcache_invalidate(uint parent, const char *name, uint hash) {
+    struct dentry *d = dc_find(parent, name, hash);
+    if (d) {
+        dc_drop(d);
+    }
+}
+
+// inode 被回收：删除以它为父目录或指向它的所有项（inum 会被重新分配）
+void dcache_purge(uint inum) {
+    for (int i = 0; i < NDCACHE; i++) {
+        struct dentry *d = &dentries[i];
+        if (d->parent && (d->parent == inum || d->inum == inum)) {
+            dc_drop(d);
+        }
+    }
+}
+
+void dcache_dump(void) {
+    int used = 0;
+    for (int i = 0; i < NDCACHE; i++) {
+        used += dentries[i].parent != 0;
+    }
+    printf("dcache: %d/%d entries, hits %d, negative hits %d, misses %d, evictions %d\n",
+           used, NDCACHE, (int)dcache_stats.hits, (int)dcache_stats.neg_hits,
+           (int)dcache_stats.misses, (int)dcache_stats.evictions);
+}
@@ -0,0 +1,231 @@
+// kernel/exec.c
+// 从文件系统加载 ELF 用户程序；段按页懒加载，只有被访问的页才会被复制
+#include "riscv.h"
+#include "elf.h"
+#include "printf.h"
+#include "string.h"
+#include "fs.h"
+#include "journal.h"
+#include "mm/pmm.h"
+#include "mm/vm.h"
+#include "proc/proc.h"
+#include "uring.h"
+#include "vdso.h"
+#include "klog.h"
+
+#define MAXARG 16
+
+static int flags2perm(uint32_t flags) {
+    int perm = 0;
+    if (flags & ELF_PROG_FLAG_READ)  perm |= PTE_R;
+    if (flags & ELF_PROG_FLAG_WRITE) perm |= PTE_W;
+    if (flags & ELF_PROG_FLAG_EXEC)  perm |= PTE_X;
+    return perm;
+}
+
+// 读取并检查 ELF 头与程序头，生成 VMA 列表（不分配任何页）
+static int load_vmas(struct inode *ip, struct elfhdr *eh, struct vma *vmas) {
+    int nvma = 0;
+
+    if (readi(ip, eh, 0, sizeof(*eh)) != sizeof(*eh)) return -1;
+    if (eh->magic != ELF_MAGIC || eh->ident[0] != ELFCLASS64) return -1;
+    if (eh->type != ET_EXEC || eh->machine != EM_RISCV) return -1;
+    if (eh->phentsize != sizeof(struct proghdr)) return -1;
+
+    for (int i = 0; i < eh->phnum; i++) {
+        struct proghdr ph;
+        uint64_t off = eh->phoff + i * sizeof(ph);
+        if (readi(ip, &ph, off, sizeof(ph)) != sizeof(ph)) return -1;
+        if (ph.type != ELF_PROG_LOAD || ph.memsz == 0) continue;
+
+        if (ph.memsz < ph.filesz) return -1;
+        if (ph.vaddr + ph.memsz < ph.vaddr) return -1;
+        if (ph.vaddr < USERBASE || ph.vaddr + ph.memsz > USTACKTOP - USTACKSIZE) return -1;
+        if (ph.off + ph.filesz > ip->size) return -1;
+        if (nvma >= NVMA - 1) return -1;  // 留一个给用户栈
+
+        struct vma *v = &vmas[nvma++];
+        v->start = PGROUNDDOWN(ph.vaddr);
+        v->end = PGROUNDUP(ph.vaddr + ph.memsz);
+        v->file_va = ph.vaddr;
+        v->off = ph.off;
+        v->filesz = ph.filesz;
+        v->perm = flags2perm(ph.flags);
+        v->ip = ip;
+    }
+    if (nvma == 0) return -1;
+
+    // 用户栈：匿名映射，按需分配
+    struct vma *sv = &vmas[nvma++];
+    sv->start = USTACKTOP - USTACKSIZE;
+    sv->end = USTACKTOP;
+    sv->perm = PTE_R | PTE_W;
+    sv->ip = 0;
+    return nvma;
+}
+
+// 把 argv 复制到新栈顶页 stackpage（对应 USTACKTOP - PGSIZE），返回用户 sp
+static uint64_t push_args(char *stackpage, char **argv, int *pargc) {
+    uint64_t base = USTACKTOP - PGSIZE;
+    uint64_t sp = USTACKTOP;
+    uint64_t ustack[MAXARG + 1];
+    int argc;
+
+    for (argc = 0; argv && argv[argc]; argc++) {
+        if (argc >= MAXARG) return 0;
+        uint64_t len = strlen(argv[argc]) + 1;
+        sp = (sp - len) & ~0xFUL;
+        if (sp < base + sizeof(ustack)) return 0;
+        memcpy(stackpage + (sp - base), argv[argc], len);
+        ustack[argc] = sp;
+    }
+    ustack[argc] = 0;
+
+    sp = (sp - (argc + 1) * sizeof(uint64_t)) & ~0xFUL;
+    memcpy(stackpage + (sp - base), ustack, (argc + 1) * sizeof(uint64_t));
+    *pargc = argc;
+    return sp;
+}
+
+// 用 path 指向的 ELF 替换当前进程的用户映像
+// 成功返回 argc（作为新程序的 a0），失败返回 -1 且原映像不变
+int exec_load(const char *path, char **argv) {
+    struct proc *p = current_proc;
+    struct elfhdr eh;
+    struct vma vmas[NVMA];
+
+    struct inode *ip = namei(path);
+    if (!ip || ip->type != FT_REG) return -1;
+
+    memset(vmas, 0, sizeof(vmas));
+    if (load_vmas(ip, &eh, vmas) < 0) {
+        printf("exec: %s: bad ELF\n", path);
+        return -1;
+    }
+
+    pagetable_t pt = uvmcreate();
+    if (pt == 0) return -1;
+
+    // 只预先分配栈顶一页用来放 argv，其余页全部由缺页异常加载
+    char *stackpage = alloc_page();
+    if (stackpage == 0) {
+        uvmfree(pt);
+        return -1;
+    }
+    page_zero(stackpage);
+    if (map_page(pt, USTACKTOP - PGSIZE, (uint64_t)stackpage, PTE_R | PTE_W | PTE_U) < 0) {
+        free_page(stackpage);
+        uvmfree(pt);
+        return -1;
+    }
+
+    if (vdso_map(pt) < 0) {
+        uvmfree(pt);
+        return -1;
+    }
+
+    int argc;
+    uint64_t sp = push_args(stackpage, argv, &argc);
+    if (sp == 0) {
+        uvmfree(pt);
+        return -1;
+    }
+
+    // 提交：此后不能失败
+    pagetable_t old = p->pagetable;
+    uring_free(p);  // 提交环不跨 exec 保留
+    vma_free(p);
+    p->pagetable = pt;
+    memcpy(p->vma, vmas, sizeof(vmas));
+    for (int i = 0; i < NVMA; i++) {
+        if (p->vma[i].ip) {
+            idup(p->vma[i].ip);  // 映射期间文件被 unlink 也不会被回收
+        }
+    }
+
+    struct trapframe *tf = p->trapframe;
+    tf->epc = eh.entry;
+    tf->sp = sp;
+    tf->a1 = sp;  // argv；a0 = argc 由返回值设置
+
+    // 同组的其他线程仍在旧页表上运行：只放弃自己的引用，最后一个使用者才释放
+    w_satp(MAKE_SATP(pt));
+    sfence_vma();
+    uvmput(old);
+
+    klog(KLOG_DEBUG, "exec: %s entry=0x%lx argc=%d\n", path, eh.entry, argc);
+    return argc;
+}
+
+// 处理用户地址的缺页：分配一页，并从所有覆盖该页的段复制文件内容
+// kind 为缺页类型（FAULT_*），段没有相应权限（R/W/X）时也是非法访问
+// 返回 0 表示已映射，-1 表示非法访问
+int vma_fault(struct proc *p, uint64_t va, int kind) {
+    int write = kind == FAULT_WRITE;
+    if (p == 0 || p->pagetable == 0) return -1;
+    if (va < USERBASE || va >= USERTOP) return -1;
+
+    va = PGROUNDDOWN(va);
+    if (write && uvm_cow(p->pagetable, va) == 0) return 0;  // 写时复制页
+    if (walkaddr(p->pagetable, va) != 0) return -1;  // 已映射：权限错误
+
+    int perm = 0;
+    for (int i = 0; i < NVMA; i++) {
+        struct vma *v = &p->vma[i];
+        if (v->end != 0 && va >= v->start && va < v->end) {
+            perm |= v->perm;
+        }
+    }
+    if (perm == 0 ||
+        (kind == FAULT_WRITE && !(perm & PTE_W)) ||
+        (kind == FAULT_READ && !(perm & PTE_R)) ||
+        (kind == FAULT_EXEC && !(perm & PTE_X))) return -1;
+
+    char *mem = alloc_page();
+    if (mem == 0) return -1;
+    page_zero(mem);
+
+    for (int i = 0; i < NVMA; i++) {
+        struct vma *v = &p->vma[i];
+        if (v->end == 0 || v->ip == 0 || va < v->start || va >= v->end) continue;
+
+        // 本页与段文件内容 [file_va, file_va + filesz) 的交集
+        uint64_t lo = va > v->file_va ? va : v->file_va;
+        uint64_t hi = va + PGSIZE;
+        if (hi > v->file_va + v->filesz) hi = v->file_va + v->filesz;
+        if (lo < hi) {
+            readi(v->ip, mem + (lo - va), v->off + (lo - v->file_va), hi - lo);
+        }
+    }
+
+    if (map_page(p->pagetable, va, (uint64_t)mem, perm | PTE_U) < 0) {
+        free_page(mem);
+        return -1;
+    }
+    sfence_vma();
+    return 0;
+}
+
+// 释放进程的 VMA 对文件的引用（页本身随页表释放）
+// 系统调用复制用户缓冲区之前，先把 [va, va+len) 的页调入（写时顺便解除写时复制），
+// 复制途中就不会缺页：在持有缓存块或处于日志事务中时被缺页结束，缓存块与事务都不会释放
+// 返回 -1 表示缓冲区中有不能这样访问的页
+int vma_prefault(struct proc *p, uint64_t va, uint64_t len, int write) {
+    for (uint64_t a = PGROUNDDOWN(va); a < va + len; a += PGSIZE) {
+        if (uvm_accessible(p->pagetable, a, write)) continue;
+        if (vma_fault(p, a, write ? FAULT_WRITE : FAULT_READ) < 0) return -1;
+    }
+    return 0;
+}
+
+void vma_free(struct proc *p) {
+    for (int i = 0; i < NVMA; i++) {
+        if (p->vma[i].ip) {
+            begin_op();
+            iput(p->vma[i].ip);
+            end_op();
+        }
+        p->vma[i].end = 0;
+        p->vma[i].ip = 0;
+    }
+}
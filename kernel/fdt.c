@@ -0,0 +1,306 @@
+// kernel/fdt.c
+// 扁平设备树解析：只读取内核需要的节点（memory、cpu、UART、PLIC、test finisher、virtio、/chosen）
+// 在 main 的第一步调用，此时还不能打印，结果由 fdt_dump 在串口可用后输出
+#include "fdt.h"
+#include "printf.h"
+#include "string.h"
+#include "console.h"
+
+#define FDT_MAGIC      0xd00dfeed
+#define FDT_BEGIN_NODE 1
+#define FDT_END_NODE   2
+#define FDT_PROP       3
+#define FDT_NOP        4
+#define FDT_END        9
+#define FDT_MAXDEPTH   8
+
+struct fdt_header {
+    uint32_t magic;
+    uint32_t totalsize;
+    uint32_t off_dt_struct;
+    uint32_t off_dt_strings;
+    uint32_t off_mem_rsvmap;
+    uint32_t version;
+    uint32_t last_comp_version;
+    uint32_t boot_cpuid_phys;
+    uint32_t size_dt_strings;
+    uint32_t size_dt_struct;
+};
+
+// 正在解析的节点：属性都在子节点之前，节点结束时再归类
+struct fdt_node {
+    const char *name;
+    const char *device_type;
+    const char *compatible;
+    int compatible_len;
+    const uint8_t *reg;
+    int reg_len;
+    int irq;
+    int disabled;
+    int ndev;
+    int addr_cells;       // 本节点的 #address-cells / #size-cells（供子节点的 reg 使用）
+    int size_cells;
+};
+
+struct machine machine;
+
+// DTB 是大端的
+static uint32_t be32(const void *p) {
+    const uint8_t *b = p;
+    return ((uint32_t)b[0] << 24) | ((uint32_t)b[1] << 16) | ((uint32_t)b[2] << 8) | b[3];
+}
+
+static uint64_t be64(const void *p) {
+    return ((uint64_t)be32(p) << 32) | be32((const uint8_t*)p + 4);
+}
+
+static uint64_t read_cells(const uint8_t *p, int cells) {
+    return cells == 2 ? be64(p) : be32(p);
+}
+
+// compatible 是以 0 分隔的字符串列表
+static int is_compatible(struct fdt_node *n, const char *c) {
+    for (int off = 0; n->compatible && off < n->compatible_len; off += strlen(n->compatible + off) + 1) {
+        if (strcmp(n->compatible + off, c) == 0) return 1;
+    }
+    return 0;
+}
+
+static void add_virtio(uint64_t base, int irq) {
+    if (machine.nvirtio == VIRTIO_SLOTS) return;
+    int i = machine.nvirtio++;
+    // QEMU 按地址降序列出槽位，插入排序成升序，与默认的槽位编号一致
+    for (; i > 0 && machine.virtio[i - 1].base > base; i--) {
+        machine.virtio[i] = machine.virtio[i - 1];
+    }
+    machine.virtio[i].base = base;
+    machine.virtio[i].irq = irq;
+}
+
+// 节点结束：parent 提供解释 reg 所需的 cell 数
+static void fdt_node_done(struct fdt_node *n, struct fdt_node *parent) {
+    int ac = parent->addr_cells, sc = parent->size_cells;
+    int tuple = 4 * (ac + sc);
+    uint64_t base = n->reg_len >= 4 * ac ? read_cells(n->reg, ac) : 0;
+
+    if (n->disabled) return;
+    if (n->device_type && strcmp(n->device_type, "memory") == 0) {
+        for (int off = 0; off + tuple <= n->reg_len && machine.nmem < NMEMRANGE; off += tuple) {
+            uint64_t size = read_cells(n->reg + off + 4 * ac, sc);
+            if (size == 0) continue;
+            machine.mem[machine.nmem].base = read_cells(n->reg + off, ac);
+            machine.mem[machine.nmem].size = size;
+            machine.nmem++;
+        }
+    } else if (n->device_type && strcmp(n->device_type, "cpu") == 0) {
+        machine.nharts++;
+    } else if (is_compatible(n, "ns16550a")) {
+        if (machine.uart == 0) {
+            machine.uart = base;
+            machine.uart_irq = n->irq;
+        }
+    } else if (is_compatible(n, "riscv,plic0") || is_compatible(n, "sifive,plic-1.0.0")) {
+        machine.plic = base;
+        machine.plic_ndev = n->ndev;
+    } else if (is_compatible(n, "sifive,test1") || is_compatible(n, "sifive,test0")) {
+        machine.finisher = base;
+    } else if (is_compatible(n, "virtio,mmio")) {
+        add_virtio(base, n->irq);
+    }
+}
+
+static int fdt_parse(const struct fdt_header *h) {
+    const uint8_t *blob = (const uint8_t*)h;
+    const uint8_t *p = blob + be32(&h->off_dt_struct);
+    const uint8_t *pend = p + be32(&h->size_dt_struct);
+    const char *strings = (const char*)blob + be32(&h->off_dt_strings);
+    struct fdt_node stack[FDT_MAXDEPTH + 1];
+    int depth = 0;   // stack[0] 是虚拟的父节点，根节点在 stack[1]
+
+    memset(stack, 0, sizeof(stack));
+    stack[0].addr_cells = 2;
+    stack[0].size_cells = 1;
+
+    while (p < pend) {
+        uint32_t tok = be32(p);
+        p += 4;
+        if (tok == FDT_BEGIN_NODE) {
+            if (++depth > FDT_MAXDEPTH) return -1;
+            struct fdt_node *n = &stack[depth];
+            memset(n, 0, sizeof(*n));
+            n->name = (const char*)p;
+            n->addr_cells = 2;   // 规范的默认值
+            n->size_cells = 1;
+            p += (strlen(n->name) + 4) & ~3;
+        } else if (tok == FDT_END_NODE) {
+            if (depth == 0) return -1;
+            fdt_node_done(&stack[depth], &stack[depth - 1]);
+            depth--;
+        } else if (tok == FDT_PROP) {
+            uint32_t len = be32(p);
+            const char *pname = strings + be32(p + 4);
+            const uint8_t *val = p + 8;
+            struct fdt_node *n = &stack[depth];
+            p += 8 + ((len + 3) & ~3);
+
+            if (strcmp(pname, "device_type") == 0) {
+                n->device_type = (const char*)val;
+            } else if (strcmp(pname, "compatible") == 0) {
+                n->compatible = (const char*)val;
+                n->compatible_len = len;
+            } else if (strcmp(pname, "reg") == 0) {
+                n->reg = val;
+                n->reg_len = len;
+            } else if (strcmp(pname, "interrupts") == 0 && len >= 4) {
+                n->irq = be32(val);
+            } else if (strcmp(pname, "status") == 0) {
+                n->disabled = strcmp((const char*)val, "okay") != 0 && strcmp((const char*)val, "ok") != 0;
+            } else if (strcmp(pname, "riscv,ndev") == 0 && len >= 4) {
+                n->ndev = be32(val);
+            } else if (strcmp(pname, "#address-cells") == 0 && len >= 4) {
+                n->addr_cells = be32(val);
+            } else if (strcmp(pname, "#size-cells") == 0 && len >= 4) {
+                n->size_cells = be32(val);
+            } else if (strcmp(pname, "bootargs") == 0 && depth == 2 &&
+                       strcmp(stack[depth].name, "chosen") == 0 && len > 0) {
+                int m = len < sizeof(machine.bootargs) ? len : sizeof(machine.bootargs);
+                memcpy(machine.bootargs, val, m);
+                machine.bootargs[m - 1] = 0;
+            }
+        } else if (tok == FDT_NOP) {
+            continue;
+        } else if (tok == FDT_END) {
+            return 0;
+        } else {
+            return -1;
+        }
+    }
+    return -1;
+}
+
+static void set_defaults(void) {
+    memset(&machine, 0, sizeof(machine));
+    machine.nmem = 1;
+    machine.mem[0].base = KERNBASE;
+    machine.mem[0].size = PHYSTOP - KERNBASE;
+    machine.nharts = 1;
+    machine.uart = UART0;
+    machine.uart_irq = UART0_IRQ;
+    machine.plic = PLIC;
+    machine.finisher = TEST_FINISHER;
+    machine.nvirtio = VIRTIO_SLOTS;
+    for (int i = 0; i < VIRTIO_SLOTS; i++) {
+        machine.virtio[i].base = VIRTIO0 + i * PGSIZE;
+        machine.virtio[i].irq = VIRTIO0_IRQ + i;
+    }
+}
+
+// dtb 为 QEMU 传入的物理地址；解析失败时回退到默认值
+void fdt_init(uint64_t dtb) {
+    const struct fdt_header *h = (const struct fdt_header*)dtb;
+    struct machine def;
+
+    set_defaults();
+    if (dtb == 0 || (dtb & 3) || be32(&h->magic) != FDT_MAGIC) return;
+    def = machine;
+
+    memset(&machine, 0, sizeof(machine));
+    if (fdt_parse(h) < 0 || machine.nmem == 0) {
+        machine = def;
+        return;
+    }
+    machine.from_fdt = 1;
+    if (machine.nharts == 0) machine.nharts = 1;
+    if (machine.uart == 0) {
+        machine.uart = def.uart;
+        machine.uart_irq = def.uart_irq;
+    }
+    if (machine.plic == 0) machine.plic = def.plic;
+
+    // DTB 自身与 /memreserve/ 条目不能交给 pmm
+    machine.resv[machine.nresv].base = PGROUNDDOWN(dtb);
+    machine.resv[machine.nresv].size = PGROUNDUP(dtb + be32(&h->totalsize)) - PGROUNDDOWN(dtb);
+    machine.nresv++;
+    const uint8_t *rsv = (const uint8_t*)dtb + be32(&h->off_mem_rsvmap);
+    for (; machine.nresv < NRESERVED; rsv += 16) {
+        uint64_t base = be64(rsv), size = be64(rsv + 8);
+        if (size == 0) break;
+        machine.resv[machine.nresv].base = PGROUNDDOWN(base);
+        machine.resv[machine.nresv].size = PGROUNDUP(base + size) - PGROUNDDOWN(base);
+        machine.nresv++;
+    }
+}
+
+// 经 test finisher 关机，QEMU 以 code 为退出码（0 为成功）；没有 finisher 时停机
+void machine_exit(int code) {
+    console_flush();
+    if (machine.finisher) {
+        volatile uint32_t *f = (volatile uint32_t*)machine.finisher;
+        *f = code == 0 ? FINISHER_PASS : ((uint32_t)code << 16) | FINISHER_FAIL;
+    }
+    printf("machine_exit: no test finisher, halting (code %d)\n", code);
+    console_flush();
+    intr_off();
+    while (1);
+}
+
+// 在 bootargs 中查找空格分隔的 name 或 name=<十进制数>
+// 找到返回 1，带值时写入 *val（没有值时 *val 不变）；找不到返回 0
+int machine_bootarg(const char *name, int *val) {
+    int n = strlen(name);
+    for (const char *p = machine.bootargs; *p; ) {
+        while (*p == ' ') p++;
+        const char *q = p;
+        while (*q && *q != ' ') q++;
+        int i = 0;
+        while (i < n && p + i < q && p[i] == name[i]) i++;
+        if (i == n && (p + n == q || p[n] == '=')) {
+            if (p[n] == '=' && val) {
+                int v = 0;
+                for (const char *d = p + n + 1; d < q && *d >= '0' && *d <= '9'; d++) {
+                    v = v * 10 + (*d - '0');
+                }
+                *val = v;
+            }
+            return 1;
+        }
+        p = q;
+    }
+    return 0;
+}
+
+// 最高的物理内存地址（不含）
+uint64_t machine_ram_end(void) {
+    uint64_t e = 0;
+    for (int i = 0; i < machine.nmem; i++) {
+        if (machine.mem[i].base + machine.mem[i].size > e) {
+            e = machine.mem[i].base + machine.mem[i].size;
+        }
+    }
+    return e;
+}
+
+void fdt_dump(void) {
+    printf("fdt: %s\n", machine.from_fdt ? "machine description from device tree" : "no device tree, using QEMU virt defaults");
+    for (int i = 0; i < machine.nmem; i++) {
+        printf("  memory  0x%lx - 0x%lx (%lu MB)\n", machine.mem[i].base,
+               machine.mem[i].base + machine.mem[i].size, machine.mem[i].size >> 20);
+    }
+    for (int i = 0; i < machine.nresv; i++) {
+        printf("  reserved 0x%lx - 0x%lx\n", machine.resv[i].base, machine.resv[i].base + machine.resv[i].size);
+    }
+    printf("  harts   %d\n", machine.nharts);
+    printf("  uart    0x%lx irq %d\n", machine.uart, machine.uart_irq);
+    printf("  plic    0x%lx ndev %d\n", machine.plic, machine.plic_ndev);
+    if (machine.finisher) {
+        printf("  finisher 0x%lx\n", machine.finisher);
+    }
+    printf("  virtio  %d slots", machine.nvirtio);
+    if (machine.nvirtio) {
+        printf(" at 0x%lx irq %d", machine.virtio[0].base, machine.virtio[0].irq);
+    }
+    printf("\n");
+    if (machine.bootargs[0]) {
+        printf("  bootargs \"%s\"\n", machine.bootargs);
+    }
+}
@@ -0,0 +1,198 @@
+// kernel/file.c
+// 打开文件对象与每进程 fd 表
+#include "file.h"
+#include "fs.h"
+#include "printf.h"
+#include "string.h"
+#include "mm/pmm.h"
+#include "proc/proc.h"
+#include "journal.h"
+#include "pipe.h"
+
+static struct file ftable[NFILE];
+static struct fdtable fdtables[NPROC];
+
+// 所有进程的 0/1/2 都指向同一个控制台文件
+static struct file console_file = { .type = FD_CONSOLE, .ref = 1 };
+
+struct file* filealloc(void) {
+    for (int i = 0; i < NFILE; i++) {
+        if (ftable[i].ref == 0) {
+            ftable[i].ref = 1;
+            ftable[i].type = FD_NONE;
+            ftable[i].ip = 0;
+            ftable[i].pipe = 0;
+            ftable[i].readable = 0;
+            ftable[i].writable = 0;
+            ftable[i].off = 0;
+            ftable[i].ra_pos = 0;
+            ftable[i].ra_end = 0;
+            ftable[i].ra_pages = 0;
+            return &ftable[i];
+        }
+    }
+    printf("filealloc: file table full\n");
+    return 0;
+}
+
+struct file* filedup(struct file *f) {
+    f->ref++;
+    return f;
+}
+
+void fileclose(struct file *f) {
+    if (--f->ref > 0) return;
+    if (f->type == FD_INODE) {
+        begin_op();  // 最后一个引用可能回收已 unlink 的文件
+        iput(f->ip);
+        end_op();
+    } else if (f->type == FD_PIPE) {
+        pipeclose(f->pipe, f->writable);
+    }
+    f->type = FD_NONE;
+    f->ip = 0;
+    f->pipe = 0;
+}
+
+// 顺序读检测：从上次读的结尾继续读时，预读窗口从 RA_MIN_PAGES 开始逐次翻倍，
+// 预读始终领先读位置一个窗口，领先不足半个窗口时再提交一段
+// 非顺序访问关闭预读，只读请求的页
+void file_readahead(struct file *f, uint off, int n) {
+    if (n <= 0 || off >= f->ip->size) return;
+
+    uint first = off / BSIZE;
+    uint last = (off + n - 1) / BSIZE;
+    if (off != f->ra_pos) {
+        f->ra_pos = off + n;
+        f->ra_pages = 0;
+        return;
+    }
+    f->ra_pos = off + n;
+
+    if (f->ra_pages == 0) {
+        f->ra_pages = RA_MIN_PAGES;
+        f->ra_end = first;  // 本次读的页与预读一起提交，合并成一个请求
+    } else if (f->ra_end < first) {
+        f->ra_end = first;
+    }
+    if (f->ra_end >= last + 1 + f->ra_pages / 2) return;  // 领先量还够
+
+    if (f->ra_end > first && f->ra_pages < RA_MAX_PAGES) {
+        f->ra_pages *= 2;  // 上一窗口已被用上
+    }
+    uint target = last + 1 + f->ra_pages;
+    if (target - f->ra_end > 2 * RA_MAX_PAGES) {
+        f->ra_end = target - 2 * RA_MAX_PAGES;  // 很大的读：剩下的由 readi 同步读
+    }
+    ireadahead(f->ip, f->ra_end, target - f->ra_end);
+    f->ra_end = target;
+}
+
+// ================= fd 表 =================
+
+// 内嵌数组用满后换成一整页
+static int fdt_grow(struct fdtable *t) {
+    if (t->size >= NOFILE) return -1;
+
+    struct file **fds = alloc_page();
+    if (fds == 0) return -1;
+    page_zero(fds);
+    memcpy(fds, t->fd, t->size * sizeof(struct file*));
+    t->fd = fds;
+    t->size = NOFILE;
+    return 0;
+}
+
+static struct fdtable* fdt_new(void) {
+    for (int i = 0; i < NPROC; i++) {
+        struct fdtable *t = &fdtables[i];
+        if (t->ref == 0) {
+            memset(t, 0, sizeof(*t));
+            t->ref = 1;
+            t->size = NFD_INLINE;
+            t->fd = t->inline_fd;
+            return t;
+        }
+    }
+    printf("fdt_alloc: no free fd table\n");
+    return 0;
+}
+
+// 新 fd 表：0/1/2 指向控制台
+struct fdtable* fdt_alloc(void) {
+    struct fdtable *t = fdt_new();
+    if (t == 0) return 0;
+    for (int fd = 0; fd < 3; fd++) {
+        fd_install(t, filedup(&console_file));
+    }
+    return t;
+}
+
+// 复制 fd 表（创建子进程时继承），fd 编号不变，打开文件对象被共享
+struct fdtable* fdt_copy(struct fdtable *src) {
+    struct fdtable *t = fdt_new();
+    if (t == 0) return 0;
+
+    if (src->size > t->size && fdt_grow(t) < 0) {
+        fdt_put(t);
+        return 0;
+    }
+    for (int w = 0; w < FDMAP_WORDS; w++) {
+        t->open[w] = src->open[w];
+        for (uint64_t bits = src->open[w]; bits; bits &= bits - 1) {
+            int fd = w * 64 + __builtin_ctzll(bits);
+            t->fd[fd] = filedup(src->fd[fd]);
+        }
+    }
+    return t;
+}
+
+void fdt_put(struct fdtable *t) {
+    if (--t->ref > 0) return;
+
+    for (int w = 0; w < FDMAP_WORDS; w++) {
+        for (uint64_t bits = t->open[w]; bits; bits &= bits - 1) {
+            fileclose(t->fd[w * 64 + __builtin_ctzll(bits)]);
+        }
+        t->open[w] = 0;
+    }
+    if (t->fd != t->inline_fd) {
+        free_page(t->fd);
+    }
+    t->fd = 0;
+}
+
+// 把 f 装入最小的空闲 fd 并返回该 fd
+int fd_install(struct fdtable *t, struct file *f) {
+    for (int w = 0; w < FDMAP_WORDS; w++) {
+        if (t->open[w] == ~0ULL) continue;
+
+        int fd = w * 64 + __builtin_ctzll(~t->open[w]);
+        if (fd >= t->size && fdt_grow(t) < 0) {
+            return -1;
+        }
+        t->open[w] |= 1ULL << (fd % 64);
+        t->fd[fd] = f;
+        return fd;
+    }
+    return -1;
+}
+
+struct file* fd_get(struct fdtable *t, int fd) {
+    if (t == 0 || fd < 0 || fd >= t->size) return 0;
+    return t->fd[fd];
+}
+
+// 释放 fd，返回它指向的文件（由调用者 fileclose）
+struct file* fd_remove(struct fdtable *t, int fd) {
+    struct file *f = fd_get(t, fd);
+    if (f == 0) return 0;
+    t->fd[fd] = 0;
+    t->open[fd / 64] &= ~(1ULL << (fd % 64));
+    return f;
+}
+
+// 当前进程的 fd -> 打开文件对象
+struct file* fd_lookup(int fd) {
+    return current_proc ? fd_get(current_proc->fdt, fd) : 0;
+}
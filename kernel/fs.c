@@ -1,186 +1,817 @@
 // kernel/fs.c
+// 磁盘文件系统的 inode 层：所有块经 kernel/blk/pcache.c 的页缓存读写
+// 布局：[0 未用 | 1 超级块 | 日志 | inode 块 | 位图块 | 数据块]，块大小 = 页大小
+// 文件内容用三层索引（直接/一级间接/二级间接块），只有写入过的块才会分配
+// 元数据（位图、inode、索引块、目录内容）经 log_write 进入日志，调用者负责 begin_op/end_op
 #include "fs.h"
-#include "proc.h"
 #include "printf.h"
+#include "string.h"
+#include "mm/pmm.h"
+#include "blk/blk.h"
+#include "dcache.h"
+#include "journal.h"
 
-#define NINODE 50
-#define ROOT_INUM 1
+struct superblock sb;
+struct inode inodes[NINODE];   // 全部 inode 常驻内存，inum = 下标 + 1
+struct inode *root_inode;
 
-struct inode inodes[NINODE];
-struct inode root_inode;
-int next_inum = 2;
+static uint balloc_hint;   // 上次分配位置，下次从这里继续找
 
-struct file ftable[MAX_OPEN_FILES];
+static void mkfs(uint nblocks);
+static void iload(void);
 
 void fs_init(void) {
-    // 初始化根目录
-    root_inode.inum = ROOT_INUM;
-    root_inode.type = FT_DIR;
-    root_inode.nlink = 1;
-    root_inode.size = 0;
+    blk_init();
 
-    for (int i = 0; i < MAX_OPEN_FILES; i++) {
-        ftable[i].type = FD_NONE;
+    dcache_init();
+
+    struct buf *b = bread(SUPERBLOCK);
+    memcpy(&sb, b->data, sizeof(sb));
+    brelse(b);
+
+    if (sb.magic != FS_MAGIC || sb.version != FS_VERSION || sb.ninodes != NINODE ||
+        sb.size > blkdev->nblocks) {
+        mkfs(blkdev->nblocks);  // 同时建立内存中的 inode 表
+    } else {
+        journal_init(sb.logstart, sb.nlog);  // 先重放日志再读 inode
+        iload();
+    }
+    balloc_hint = sb.datastart;
+
+    root_inode = &inodes[ROOT_INUM - 1];
+    root_inode->ref = 1;
+
+    printf("fs_init: %d blocks, %d inodes, data starts at block %d\n",
+           sb.size, sb.ninodes, sb.datastart);
+}
+
+// ================= 块分配 =================
+
+// 分配一个清零的数据块，磁盘满时返回 0
+static uint balloc(void) {
+    for (uint i = 0; i < sb.size; i++) {
+        uint bno = balloc_hint + i;
+        if (bno >= sb.size) bno -= sb.size - sb.datastart;  // 回绕到数据区开头
+
+        struct buf *b = bread(BBLOCK(bno));
+        uint8_t *map = (uint8_t*)b->data;
+        uint bit = bno % BPB;
+        if ((map[bit / 8] & (1 << (bit % 8))) == 0) {
+            map[bit / 8] |= 1 << (bit % 8);
+            log_write(b);
+            brelse(b);
+
+            // 清零不进日志：数据块在提交前写回，元数据块的整块内容会进日志
+            b = bget_zero(bno);
+            bwrite(b);
+            brelse(b);
+            balloc_hint = bno + 1;
+            return bno;
+        }
+        brelse(b);
+    }
+    printf("balloc: out of blocks\n");
+    return 0;
+}
+
+static void bfree(uint bno) {
+    struct buf *b = bread(BBLOCK(bno));
+    uint8_t *map = (uint8_t*)b->data;
+    uint bit = bno % BPB;
+    if ((map[bit / 8] & (1 << (bit % 8))) == 0) {
+        printf("bfree: block %d already free\n", bno);
+    }
+    map[bit / 8] &= ~(1 << (bit % 8));
+    log_write(b);
+    brelse(b);
+}
+
+// 首次启动（或超级块无效）时格式化设备
+static void mkfs(uint nblocks) {
+    printf("mkfs: formatting %d blocks\n", nblocks);
+
+    memset(&sb, 0, sizeof(sb));
+    sb.magic = FS_MAGIC;
+    sb.version = FS_VERSION;
+    sb.size = nblocks;
+    sb.ninodes = NINODE;
+    sb.logstart = SUPERBLOCK + 1;
+    sb.nlog = LOG_BLOCKS;
+    sb.inodestart = sb.logstart + sb.nlog;
+    sb.bmapstart = sb.inodestart + (NINODE + 1 + IPB - 1) / IPB;
+    sb.datastart = sb.bmapstart + (nblocks + BPB - 1) / BPB;
+
+    // 元数据区清零，并在位图中标记为已用
+    for (uint bno = 0; bno < sb.datastart; bno++) {
+        struct buf *b = bget_zero(bno);
+        bwrite(b);
+        brelse(b);
+    }
+    for (uint bno = 0; bno < sb.datastart; bno++) {
+        struct buf *b = bread(BBLOCK(bno));
+        b->data[(bno % BPB) / 8] |= 1 << (bno % 8);
+        bwrite(b);
+        brelse(b);
+    }
+
+    struct buf *b = bread(SUPERBLOCK);
+    memcpy(b->data, &sb, sizeof(sb));
+    bwrite(b);
+    brelse(b);
+
+    bsync();
+    journal_init(sb.logstart, sb.nlog);
+
+    // 根目录："." 和 ".." 都指向自己
+    memset(inodes, 0, sizeof(inodes));
+    struct inode *root = &inodes[ROOT_INUM - 1];
+    begin_op();
+    root->inum = ROOT_INUM;
+    root->type = FT_DIR;
+    root->nlink = 1;
+    iupdate(root);
+    dirlink(root, ".", ROOT_INUM);
+    dirlink(root, "..", ROOT_INUM);
+    end_op();
+
+    journal_sync();
+}
+
+// ================= inode =================
+
+// 启动时把磁盘上的全部 dinode 读入内存
+static void iload(void) {
+    for (uint inum = 1; inum <= NINODE; inum++) {
+        struct inode *ip = &inodes[inum - 1];
+        struct buf *b = bread(IBLOCK(inum));
+        struct dinode *dip = (struct dinode*)b->data + inum % IPB;
+        memset(ip, 0, sizeof(*ip));
+        ip->inum = inum;
+        ip->type = dip->type;
+        ip->nlink = dip->nlink;
+        ip->size = dip->size;
+        ip->npages = dip->npages;
+        memcpy(ip->addrs, dip->addrs, sizeof(ip->addrs));
+        brelse(b);
     }
+}
 
-    printf("fs_init: RAMFS initialized\n");
+// 把内存中的 inode 写回其 dinode（记入当前事务）
+void iupdate(struct inode *ip) {
+    struct buf *b = bread(IBLOCK(ip->inum));
+    struct dinode *dip = (struct dinode*)b->data + ip->inum % IPB;
+    dip->type = ip->type;
+    dip->nlink = ip->nlink;
+    dip->size = ip->size;
+    dip->npages = ip->npages;
+    memcpy(dip->addrs, ip->addrs, sizeof(ip->addrs));
+    log_write(b);
+    brelse(b);
 }
 
 // 分配新 inode
 struct inode* ialloc(short type) {
     for (int i = 0; i < NINODE; i++) {
-        if (inodes[i].inum == 0) {
-            inodes[i].inum = next_inum++;
-            inodes[i].type = type;
-            inodes[i].nlink = 1;
-            inodes[i].size = 0;
-            return &inodes[i];
+        if (inodes[i].type == 0) {
+            struct inode *ip = &inodes[i];
+            memset(ip, 0, sizeof(*ip));
+            ip->inum = i + 1;
+            ip->type = type;
+            ip->nlink = 1;
+            iupdate(ip);
+            return ip;
         }
     }
+    printf("ialloc: no inodes\n");
     return 0;
 }
 
-// 查找路径对应的 inode（只支持根目录下文件）
-struct inode* namei(char *path) {
-    if (path[0] != '/') return 0;
-    if (path[1] == 0) return &root_inode;  // 根目录
+struct inode* iget(uint inum) {
+    if (inum == 0 || inum > NINODE || inodes[inum - 1].type == 0) {
+        return 0;
+    }
+    return &inodes[inum - 1];
+}
+
+struct inode* idup(struct inode *ip) {
+    ip->ref++;
+    return ip;
+}
 
-    // 简化：只支持 "/filename"，不支持子目录
-    char *name = path + 1;
-    if (strchr(name, '/')) return 0;  // 不支持嵌套路径
+static void dirhash_free(struct inode *dp);
 
-    // 在根目录中查找
-    for (int i = 0; i < root_inode.size; ) {
-        struct dirent *de = (struct dirent*)(root_inode.data + i);
-        if (de->inum != 0 && strcmp(de->name, name) == 0) {
-            // 找到对应 inode
-            return &inodes[de->inum - 2];  // inum 从 2 开始
+// 释放一个引用；没有链接也没有引用时回收内容与 inode
+void iput(struct inode *ip) {
+    if (ip->ref > 0) {
+        ip->ref--;
+    }
+    if (ip->ref == 0 && ip->nlink == 0 && ip->type != 0) {
+        if (ip->type == FT_DIR) {
+            dirhash_free(ip);
         }
-        i += sizeof(struct dirent);
+        itrunc(ip);
+        dcache_purge(ip->inum);
+        ip->type = 0;
+        iupdate(ip);
     }
-    return 0;  // 未找到
 }
 
-// 在目录中创建链接
-int dirlink(struct inode *dp, char *name, uint inum) {
-    if (dp->type != FT_DIR) return -1;
-    if (dp->size + sizeof(struct dirent) > MAX_FILE_SIZE) return -1;
+// 在索引块 ib 中取第 idx 项，alloc 时按需分配；data 表示分配的是数据块
+static uint index_get(struct inode *ip, uint ib, uint idx, int alloc, int data) {
+    struct buf *b = bread(ib);
+    uint *a = (uint*)b->data;
+    uint addr = a[idx];
+    if (addr == 0 && alloc && (addr = balloc()) != 0) {
+        a[idx] = addr;
+        log_write(b);
+        if (data) ip->npages++;
+    }
+    brelse(b);
+    return addr;
+}
 
-    struct dirent de;
-    de.inum = inum;
-    strcpy(de.name, name);
+// 文件第 pgno 页所在的块号；alloc 为 0 时空洞返回 0
+// 分配了新块时调用者负责 iupdate
+static uint bmap(struct inode *ip, uint64_t pgno, int alloc) {
+    uint addr;
+
+    if (pgno < NDIRECT) {
+        if ((addr = ip->addrs[pgno]) == 0 && alloc && (addr = balloc()) != 0) {
+            ip->addrs[pgno] = addr;
+            ip->npages++;
+        }
+        return addr;
+    }
+    pgno -= NDIRECT;
+
+    if (pgno < NINDIRECT) {
+        if (ip->addrs[NDIRECT] == 0) {
+            if (!alloc || (ip->addrs[NDIRECT] = balloc()) == 0) return 0;
+        }
+        return index_get(ip, ip->addrs[NDIRECT], pgno, alloc, 1);
+    }
+    pgno -= NINDIRECT;
 
-    memcpy(dp->data + dp->size, &de, sizeof(de));
-    dp->size += sizeof(struct dirent);
+    if (pgno < NINDIRECT * NINDIRECT) {
+        if (ip->addrs[NDIRECT + 1] == 0) {
+            if (!alloc || (ip->addrs[NDIRECT + 1] = balloc()) == 0) return 0;
+        }
+        uint l1 = index_get(ip, ip->addrs[NDIRECT + 1], pgno / NINDIRECT, alloc, 0);
+        if (l1 == 0) return 0;
+        return index_get(ip, l1, pgno % NINDIRECT, alloc, 1);
+    }
     return 0;
 }
 
-// 系统调用实现
-int sys_open(void) {
-    char path[64];
-    int flags;
-    argstr(0, path, sizeof(path));
-    argint(1, &flags);
+// 释放索引块 ib 下的所有块（level 为 0 时表项就是数据块）
+static void free_index(uint ib, int level) {
+    struct buf *b = bread(ib);
+    uint *a = (uint*)b->data;
+    for (int i = 0; i < NINDIRECT; i++) {
+        if (a[i] == 0) continue;
+        if (level > 0) {
+            free_index(a[i], level - 1);
+        } else {
+            bfree(a[i]);
+        }
+    }
+    brelse(b);
+    bfree(ib);
+}
 
-    // 只支持 O_CREATE | O_RDWR | O_RDONLY
-    if (flags & 1) {  // O_CREATE
-        struct inode *ip = namei(path);
-        if (ip) return -1;  // 已存在
+// 释放文件的全部内容
+void itrunc(struct inode *ip) {
+    ip->xip = 0;
+    for (int i = 0; i < NDIRECT; i++) {
+        if (ip->addrs[i]) {
+            bfree(ip->addrs[i]);
+            ip->addrs[i] = 0;
+        }
+    }
+    if (ip->addrs[NDIRECT]) {
+        free_index(ip->addrs[NDIRECT], 0);
+        ip->addrs[NDIRECT] = 0;
+    }
+    if (ip->addrs[NDIRECT + 1]) {
+        free_index(ip->addrs[NDIRECT + 1], 1);
+        ip->addrs[NDIRECT + 1] = 0;
+    }
+    ip->npages = 0;
+    ip->size = 0;
+    iupdate(ip);
+}
 
-        ip = ialloc(FT_REG);
-        if (!ip) return -1;
+// 从 off 读取最多 n 字节，空洞读出为 0
+int readi(struct inode *ip, void *dst, uint64_t off, uint64_t n) {
+    if (off >= ip->size) return 0;
+    if (off + n > ip->size) {
+        n = ip->size - off;
+    }
+    if (ip->xip) {
+        memcpy(dst, ip->xip + off, n);  // 直接从内核镜像中的 initramfs 读
+        return n;
+    }
 
-        // 添加到根目录
-        dirlink(&root_inode, path + 1, ip->inum);
-        ip->nlink = 1;
-    } else {
-        struct inode *ip = namei(path);
-        if (!ip) return -1;
+    char *d = dst;
+    for (uint64_t tot = 0, m; tot < n; tot += m, off += m, d += m) {
+        uint addr = bmap(ip, off / BSIZE, 0);
+        m = BSIZE - off % BSIZE;
+        if (m > n - tot) m = n - tot;
+        if (addr) {
+            struct buf *b = bread(addr);
+            memcpy(d, b->data + off % BSIZE, m);
+            brelse(b);
+        } else {
+            memset(d, 0, m);
+        }
     }
+    return n;
+}
+
+// 取得文件第 pgno 页所在的缓存块（调用者 brelse），空洞返回 0
+struct buf* ibread(struct inode *ip, uint64_t pgno) {
+    uint addr = bmap(ip, pgno, 0);
+    return addr ? bread(addr) : 0;
+}
 
-    // 分配文件描述符
-    for (int fd = 0; fd < MAX_OPEN_FILES; fd++) {
-        if (ftable[fd].type == FD_NONE) {
-            ftable[fd].type = FD_INODE;
-            ftable[fd].ip = namei(path);
-            ftable[fd].off = 0;
-            ftable[fd].ref = 1;
-            return fd;
+// 异步预读文件第 pgno 页起的 n 页；空洞和文件末尾之后的页跳过
+void ireadahead(struct inode *ip, uint64_t pgno, int n) {
+    uint blocks[BLK_MAX_SEGS];
+    uint64_t end = ((uint64_t)ip->size + BSIZE - 1) / BSIZE;
+    int nb = 0;
+
+    for (; n > 0 && pgno < end; n--, pgno++) {
+        uint addr = bmap(ip, pgno, 0);
+        if (addr) {
+            blocks[nb++] = addr;
+        }
+        if (nb == BLK_MAX_SEGS) {
+            breadahead(blocks, nb);
+            nb = 0;
         }
     }
-    return -1;
+    if (nb) {
+        breadahead(blocks, nb);
+    }
 }
 
-int sys_close(void) {
-    int fd;
-    argint(0, &fd);
-    if (fd < 0 || fd >= MAX_OPEN_FILES || ftable[fd].type == FD_NONE)
-        return -1;
-    ftable[fd].type = FD_NONE;
-    ftable[fd].ref = 0;
+// 在 off 写入 n 字节，按需分配块；返回写入的字节数
+static int writeblocks(struct inode *ip, const char *s, uint64_t off, uint64_t n) {
+    uint64_t tot, m;
+    for (tot = 0; tot < n; tot += m, off += m, s += m) {
+        uint addr = bmap(ip, off / BSIZE, 1);
+        if (addr == 0) break;  // 磁盘已满
+        m = BSIZE - off % BSIZE;
+        if (m > n - tot) m = n - tot;
+
+        // 整块覆盖时不必先读入
+        struct buf *b = m == BSIZE ? bget_zero(addr) : bread(addr);
+        memcpy(b->data + off % BSIZE, s, m);
+        if (ip->type == FT_DIR) {
+            log_write(b);  // 目录内容是元数据
+        } else {
+            bwrite(b);
+        }
+        brelse(b);
+    }
+    if (off > ip->size) {
+        ip->size = off;
+    }
+    iupdate(ip);
+    return tot;
+}
+
+// 仍指向 initramfs 的 inode 要先经 icopyup 复制到自己的块里，否则返回 -1
+int writei(struct inode *ip, const void *src, uint64_t off, uint64_t n) {
+    if (off > MAX_FILE_SIZE || ip->xip) return -1;
+    if (off + n > MAX_FILE_SIZE) {
+        n = MAX_FILE_SIZE - off;
+    }
+    return writeblocks(ip, src, off, n);
+}
+
+// 写时复制：把 initramfs 中的内容写到 inode 自己的块里，每 WRITE_CHUNK 字节一个事务，
+// 所以要在事务之外调用。复制期间读仍走 xip，全部写完才清掉；
+// 中途磁盘满时释放已复制的块（否则下次启动时不完整的副本会被当作磁盘上的版本），xip 保持不变
+int icopyup(struct inode *ip) {
+    const char *xip = ip->xip;
+    uint size = ip->size;
+
+    if (xip == 0) return 0;
+    for (uint64_t off = 0; off < size; off += WRITE_CHUNK) {
+        uint64_t m = size - off < WRITE_CHUNK ? size - off : WRITE_CHUNK;
+        begin_op();
+        int n = writeblocks(ip, xip + off, off, m);
+        end_op();
+        if (n != (int)m) {
+            begin_op();
+            itrunc(ip);
+            ip->xip = xip;
+            ip->size = size;
+            iupdate(ip);
+            end_op();
+            return -1;
+        }
+    }
+    ip->xip = 0;
     return 0;
 }
 
-int sys_read(void) {
-    int fd, n;
-    uint64_t buf;
-    argint(0, &fd);
-    buf = argaddr(1);
-    argint(2, &n);
+// ================= 目录哈希索引 =================
+// 每个目录在内存中维护 名字哈希 -> 目录项 的索引，查找平均 O(1)
+// 索引在第一次访问目录时由目录项扫描建立，负载因子超过 1 时桶数翻倍
 
-    if (fd < 0 || fd >= MAX_OPEN_FILES || ftable[fd].type == FD_NONE)
-        return -1;
+#define DH_BUCKETS_PER_PAGE (PGSIZE / sizeof(struct dhent*))   // 512
+#define DH_MAX_BPAGES       64                                 // 最多 32768 个桶
+
+struct dhent {
+    struct dhent *next;
+    uint hash;
+    uint off;          // 目录项在目录文件中的偏移
+    ushort inum;
+};
 
-    struct file *f = &ftable[fd];
-    struct inode *ip = f->ip;
-    if (f->off + n > ip->size) {
-        n = ip->size - f->off;
-        if (n <= 0) return 0;
+struct dirhash {
+    uint nbuckets;
+    uint count;
+    struct dhent *freeslots;   // 已删除目录项的偏移，dirlink 时复用
+    struct dhent **bpages[DH_MAX_BPAGES];
+};
+
+static struct dhent *dhent_freelist;
+
+static struct dhent* dhent_alloc(void) {
+    if (dhent_freelist == 0) {
+        struct dhent *page = alloc_page();
+        if (page == 0) return 0;
+        for (int i = 0; i < PGSIZE / sizeof(struct dhent); i++) {
+            page[i].next = dhent_freelist;
+            dhent_freelist = &page[i];
+        }
     }
+    struct dhent *e = dhent_freelist;
+    dhent_freelist = e->next;
+    return e;
+}
 
-    memcpy((void*)buf, ip->data + f->off, n);
-    f->off += n;
-    return n;
+static void dhent_free(struct dhent *e) {
+    e->next = dhent_freelist;
+    dhent_freelist = e;
 }
 
-int sys_write(void) {
-    int fd, n;
-    uint64_t buf;
-    argint(0, &fd);
-    buf = argaddr(1);
-    argint(2, &n);
+// FNV-1a
+uint name_hash(const char *name) {
+    uint h = 2166136261U;
+    while (*name) {
+        h ^= (unsigned char)*name++;
+        h *= 16777619U;
+    }
+    return h;
+}
 
-    if (fd < 0 || fd >= MAX_OPEN_FILES || ftable[fd].type == FD_NONE)
-        return -1;
+static struct dhent** dh_bucket(struct dirhash *dh, uint hash) {
+    uint b = hash & (dh->nbuckets - 1);
+    return &dh->bpages[b / DH_BUCKETS_PER_PAGE][b % DH_BUCKETS_PER_PAGE];
+}
 
-    struct file *f = &ftable[fd];
-    struct inode *ip = f->ip;
-    if (f->off + n > MAX_FILE_SIZE) return -1;
+// 桶数翻倍并重新分布；内存不足或已达上限时保持原样
+static void dh_grow(struct dirhash *dh) {
+    uint oldpages = dh->nbuckets / DH_BUCKETS_PER_PAGE;
+    if (oldpages * 2 > DH_MAX_BPAGES) return;
 
-    memcpy(ip->data + f->off, (void*)buf, n);
-    if (f->off + n > ip->size) ip->size = f->off + n;
-    f->off += n;
-    return n;
+    for (uint i = oldpages; i < oldpages * 2; i++) {
+        dh->bpages[i] = alloc_page();
+        if (dh->bpages[i] == 0) {
+            while (i-- > oldpages) {
+                free_page(dh->bpages[i]);
+                dh->bpages[i] = 0;
+            }
+            return;
+        }
+        page_zero(dh->bpages[i]);
+    }
+
+    // 旧桶 b 中的项只会留在 b 或移到 b + oldn
+    uint oldn = dh->nbuckets;
+    dh->nbuckets *= 2;
+    for (uint b = 0; b < oldn; b++) {
+        struct dhent **pp = &dh->bpages[b / DH_BUCKETS_PER_PAGE][b % DH_BUCKETS_PER_PAGE];
+        while (*pp) {
+            struct dhent *e = *pp;
+            if ((e->hash & (dh->nbuckets - 1)) != b) {
+                *pp = e->next;
+                struct dhent **nb = dh_bucket(dh, e->hash);
+                e->next = *nb;
+                *nb = e;
+            } else {
+                pp = &e->next;
+            }
+        }
+    }
+}
+
+static int dh_insert(struct dirhash *dh, uint hash, uint off, uint inum) {
+    struct dhent *e = dhent_alloc();
+    if (e == 0) return -1;
+    e->hash = hash;
+    e->off = off;
+    e->inum = inum;
+    struct dhent **b = dh_bucket(dh, hash);
+    e->next = *b;
+    *b = e;
+    if (++dh->count > dh->nbuckets) {
+        dh_grow(dh);
+    }
+    return 0;
+}
+
+// 释放目录的哈希索引
+static void dirhash_free(struct inode *dp) {
+    struct dirhash *dh = dp->dirhash;
+    if (dh == 0) return;
+
+    for (uint b = 0; b < dh->nbuckets; b++) {
+        struct dhent *e = *dh_bucket(dh, b), *next;
+        for (; e; e = next) {
+            next = e->next;
+            dhent_free(e);
+        }
+    }
+    for (struct dhent *e = dh->freeslots, *next; e; e = next) {
+        next = e->next;
+        dhent_free(e);
+    }
+    for (int i = 0; i < DH_MAX_BPAGES && dh->bpages[i]; i++) {
+        free_page(dh->bpages[i]);
+    }
+    free_page(dh);
+    dp->dirhash = 0;
 }
 
-int sys_unlink(void) {
-    char path[64];
-    argstr(0, path, sizeof(path));
+// 取得目录的哈希索引，第一次访问时扫描目录项建立
+static struct dirhash* dh_get(struct inode *dp) {
+    if (dp->dirhash) return dp->dirhash;
 
-    struct inode *ip = namei(path);
-    if (!ip) return -1;
+    struct dirhash *dh = alloc_page();
+    if (dh == 0) return 0;
+    memset(dh, 0, sizeof(*dh));
+    dh->bpages[0] = alloc_page();
+    if (dh->bpages[0] == 0) {
+        free_page(dh);
+        return 0;
+    }
+    page_zero(dh->bpages[0]);
+    dh->nbuckets = DH_BUCKETS_PER_PAGE;
+    dp->dirhash = dh;
 
-    // 从根目录中移除（简化：只支持根目录）
-    char *name = path + 1;
-    for (int i = 0; i < root_inode.size; ) {
-        struct dirent *de = (struct dirent*)(root_inode.data + i);
-        if (de->inum == ip->inum && strcmp(de->name, name) == 0) {
-            de->inum = 0;  // 标记为空
-            // 释放 inode（简化）
-            ip->inum = 0;
+    struct dirent de;
+    for (uint off = 0; off < dp->size; off += sizeof(de)) {
+        if (readi(dp, &de, off, sizeof(de)) != sizeof(de)) break;
+        int r;
+        if (de.inum != 0) {
+            r = dh_insert(dh, name_hash(de.name), off, de.inum);
+        } else {
+            struct dhent *e = dhent_alloc();
+            if ((r = e ? 0 : -1) == 0) {
+                e->off = off;
+                e->next = dh->freeslots;
+                dh->freeslots = e;
+            }
+        }
+        if (r < 0) {
+            dirhash_free(dp);
             return 0;
         }
-        i += sizeof(struct dirent);
     }
-    return -1;
+    return dh;
+}
+
+// 在哈希链中查找 name；pprev 返回指向该项的链接，便于删除
+static struct dhent* dh_find(struct inode *dp, struct dirhash *dh, const char *name,
+                             uint hash, struct dhent ***pprev) {
+    struct dirent de;
+    struct dhent **pp = dh_bucket(dh, hash);
+
+    for (; *pp; pp = &(*pp)->next) {
+        struct dhent *e = *pp;
+        if (e->hash != hash) continue;
+        if (readi(dp, &de, e->off, sizeof(de)) != sizeof(de)) continue;
+        if (strcmp(de.name, name) == 0) {
+            if (pprev) *pprev = pp;
+            return e;
+        }
+    }
+    return 0;
+}
+
+// 线性扫描（哈希索引建立失败时的后备路径）
+static struct inode* dirscan(struct inode *dp, const char *name, uint *poff) {
+    struct dirent de;
+    for (uint off = 0; off < dp->size; off += sizeof(de)) {
+        if (readi(dp, &de, off, sizeof(de)) != sizeof(de)) break;
+        if (de.inum != 0 && strcmp(de.name, name) == 0) {
+            if (poff) *poff = off;
+            return iget(de.inum);
+        }
+    }
+    return 0;
+}
+
+// 在目录中查找 name，返回 inode，并通过 poff 返回目录项偏移
+// 不需要偏移时先查目录项缓存，命中（包括负缓存）就不再访问目录
+struct inode* dirlookup(struct inode *dp, const char *name, uint *poff) {
+    if (dp->type != FT_DIR) return 0;
+
+    uint hash = name_hash(name);
+    uint inum;
+    if (poff == 0 && dcache_lookup(dp->inum, name, hash, &inum)) {
+        return inum ? iget(inum) : 0;
+    }
+
+    struct inode *ip;
+    struct dirhash *dh = dh_get(dp);
+    if (dh == 0) {
+        ip = dirscan(dp, name, poff);
+    } else {
+        struct dhent *e = dh_find(dp, dh, name, hash, 0);
+        if (e && poff) *poff = e->off;
+        ip = e ? iget(e->inum) : 0;
+    }
+    dcache_insert(dp->inum, name, hash, ip ? ip->inum : 0);
+    return ip;
+}
+
+// 在目录中创建链接（优先复用已删除的目录项）
+int dirlink(struct inode *dp, const char *name, uint inum) {
+    struct dirent de;
+
+    if (dp->type != FT_DIR) return -1;
+    if (strlen(name) >= MAX_FILENAME) return -1;
+    if (dirlookup(dp, name, 0)) return -1;  // 已存在
+
+    struct dirhash *dh = dh_get(dp);
+    struct dhent *slot = dh ? dh->freeslots : 0;
+    uint off = slot ? slot->off : dp->size;
+
+    memset(&de, 0, sizeof(de));
+    de.inum = inum;
+    strcpy(de.name, name);
+    if (writei(dp, &de, off, sizeof(de)) != sizeof(de)) return -1;
+
+    if (slot) {
+        // 空闲槽节点直接转为索引项
+        dh->freeslots = slot->next;
+        dhent_free(slot);
+    }
+    uint hash = name_hash(name);
+    if (dh && dh_insert(dh, hash, off, inum) < 0) {
+        dirhash_free(dp);  // 下次访问时重建
+    }
+    dcache_insert(dp->inum, name, hash, inum);  // 覆盖可能存在的负缓存
+    return 0;
+}
+
+// 删除目录项并减少链接数
+int dirunlink(struct inode *dp, const char *name) {
+    struct dirent de;
+    struct inode *ip;
+    uint off;
+
+    if (strcmp(name, ".") == 0 || strcmp(name, "..") == 0) return -1;
+
+    uint hash = name_hash(name);
+    struct dirhash *dh = dh_get(dp);
+    if (dh) {
+        struct dhent **pp;
+        struct dhent *e = dh_find(dp, dh, name, hash, &pp);
+        if (e == 0) return -1;
+        ip = iget(e->inum);
+        off = e->off;
+
+        // 从哈希链摘下，转为空闲槽
+        *pp = e->next;
+        dh->count--;
+        e->next = dh->freeslots;
+        dh->freeslots = e;
+    } else if ((ip = dirscan(dp, name, &off)) == 0) {
+        return -1;
+    }
+
+    memset(&de, 0, sizeof(de));
+    writei(dp, &de, off, sizeof(de));
+    dcache_insert(dp->inum, name, hash, 0);
+
+    if (ip) {
+        ip->nlink--;
+        iupdate(ip);
+        idup(ip);
+        iput(ip);  // 没有其他引用时立即回收
+    }
+    return 0;
+}
+
+// ================= 路径解析 =================
+
+// 取出路径的下一个分量到 name，返回剩余路径；没有分量时返回 0
+// 例：skipelem("a/bb/c", name) = "bb/c"，name = "a"
+static const char* skipelem(const char *path, char *name) {
+    while (*path == '/') path++;
+    if (*path == 0) return 0;
+
+    const char *s = path;
+    while (*path != '/' && *path != 0) path++;
+    int len = path - s;
+    if (len >= MAX_FILENAME) len = MAX_FILENAME - 1;
+    memcpy(name, s, len);
+    name[len] = 0;
+
+    while (*path == '/') path++;
+    return path;
+}
+
+// 逐级解析绝对路径；parent 为 1 时返回最后一个分量的父目录
+static struct inode* namex(const char *path, int parent, char *name) {
+    if (path[0] != '/') return 0;  // 没有 cwd，只支持绝对路径
+
+    struct inode *ip = root_inode;
+    while ((path = skipelem(path, name)) != 0) {
+        if (ip->type != FT_DIR) return 0;
+        if (parent && *path == '\0') {
+            return ip;  // 提前一级停止
+        }
+        ip = dirlookup(ip, name, 0);
+        if (ip == 0) return 0;
+    }
+    if (parent) return 0;  // 路径是 "/"
+    return ip;
+}
+
+struct inode* namei(const char *path) {
+    char name[MAX_FILENAME];
+    return namex(path, 0, name);
+}
+
+struct inode* nameiparent(const char *path, char *name) {
+    return namex(path, 1, name);
+}
+
+// 创建普通文件或目录；已存在时返回 0
+struct inode* fs_create(const char *path, short type) {
+    char name[MAX_FILENAME];
+    struct inode *dp = nameiparent(path, name);
+    if (dp == 0 || dirlookup(dp, name, 0)) return 0;
+
+    struct inode *ip = ialloc(type);
+    if (ip == 0) return 0;
+
+    if (type == FT_DIR) {
+        // "." 不计入链接数，".." 计入父目录
+        if (dirlink(ip, ".", ip->inum) < 0 || dirlink(ip, "..", dp->inum) < 0) {
+            goto bad;
+        }
+    }
+    if (dirlink(dp, name, ip->inum) < 0) {
+        goto bad;
+    }
+    if (type == FT_DIR) {
+        dp->nlink++;
+        iupdate(dp);
+    }
+    return ip;
+
+bad:
+    ip->nlink = 0;
+    idup(ip);
+    iput(ip);
+    return 0;
+}
+
+// 删除普通文件
+int fs_unlink(const char *path) {
+    char name[MAX_FILENAME];
+    struct inode *dp = nameiparent(path, name);
+    if (dp == 0) return -1;
+
+    struct inode *ip = dirlookup(dp, name, 0);
+    if (ip == 0 || ip->type == FT_DIR) return -1;  // 目录用 rmdir
+    return dirunlink(dp, name);
+}
+
+// 删除空目录
+int fs_rmdir(const char *path) {
+    char name[MAX_FILENAME];
+    struct inode *dp = nameiparent(path, name);
+    if (dp == 0) return -1;
+
+    struct inode *ip = dirlookup(dp, name, 0);
+    if (ip == 0 || ip->type != FT_DIR || ip == root_inode) return -1;
+
+    // 只剩 "." 和 ".." 才算空
+    struct dirhash *dh = dh_get(ip);
+    if (dh == 0 || dh->count > 2) return -1;
+
+    if (dirunlink(dp, name) < 0) return -1;
+    dp->nlink--;
+    iupdate(dp);
+    return 0;
 }
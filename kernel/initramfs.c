@@ -0,0 +1,118 @@
+// kernel/initramfs.c
+// 解析内核镜像中的 cpio newc 归档，把每一项挂到文件系统上
+// 文件 inode 的 xip 指向归档中的数据，读直接从镜像复制，不占磁盘块
+#include "initramfs.h"
+#include "fs.h"
+#include "printf.h"
+#include "string.h"
+#include "journal.h"
+
+#define CPIO_MAGIC  "070701"
+#define CPIO_HDRSZ  110
+#define S_IFMT      0170000
+#define S_IFDIR     0040000
+#define S_IFREG     0100000
+
+// newc 头部：6 字节魔数后是 13 个 8 位十六进制字段
+struct cpio_newc {
+    char magic[6];
+    char ino[8];
+    char mode[8];
+    char uid[8];
+    char gid[8];
+    char nlink[8];
+    char mtime[8];
+    char filesize[8];
+    char devmajor[8];
+    char devminor[8];
+    char rdevmajor[8];
+    char rdevminor[8];
+    char namesize[8];
+    char check[8];
+};
+
+static uint hex8(const char *s) {
+    uint v = 0;
+    for (int i = 0; i < 8; i++) {
+        char c = s[i];
+        v <<= 4;
+        if (c >= '0' && c <= '9') v |= c - '0';
+        else if (c >= 'a' && c <= 'f') v |= c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F') v |= c - 'A' + 10;
+    }
+    return v;
+}
+
+static int is_magic(const char *s) {
+    for (int i = 0; i < 6; i++) {
+        if (s[i] != CPIO_MAGIC[i]) return 0;
+    }
+    return 1;
+}
+
+// 挂一个普通文件：新建的或上次启动挂上后没被改过的（没有自己的块且大小不变）指向归档
+static int mount_file(const char *path, const char *data, uint size) {
+    struct inode *ip = namei(path);
+    if (ip == 0) {
+        if ((ip = fs_create(path, FT_REG)) == 0) return -1;
+        ip->size = size;
+        iupdate(ip);
+    } else if (ip->type != FT_REG || ip->npages != 0 || ip->size != size) {
+        return 0;  // 磁盘上的版本优先
+    }
+    ip->xip = data;
+    return 1;
+}
+
+void initramfs_mount(void) {
+    char *p = _initramfs_start;
+    char path[64];
+    int nfiles = 0, ndirs = 0, kept = 0;
+    uint64_t bytes = 0;
+
+    while (p + CPIO_HDRSZ <= _initramfs_end) {
+        struct cpio_newc *h = (struct cpio_newc*)p;
+        if (!is_magic(h->magic)) {
+            printf("initramfs: bad header at offset %d\n", (int)(p - _initramfs_start));
+            break;
+        }
+        uint mode = hex8(h->mode);
+        uint namesize = hex8(h->namesize);
+        uint filesize = hex8(h->filesize);
+        const char *name = p + CPIO_HDRSZ;
+        const char *data = p + ((CPIO_HDRSZ + namesize + 3) & ~3);
+        p = (char*)data + ((filesize + 3) & ~3);
+
+        if (strcmp(name, "TRAILER!!!") == 0) break;
+        if (name[0] == '.' && name[1] == '/') name += 2;  // find 输出的 "./a/b"
+        if (name[0] == 0 || strcmp(name, ".") == 0) continue;
+        if (strlen(name) + 2 > sizeof(path)) {
+            printf("initramfs: %s: path too long\n", name);
+            continue;
+        }
+        path[0] = '/';
+        strcpy(path + 1, name);
+
+        begin_op();
+        if ((mode & S_IFMT) == S_IFDIR) {
+            if (namei(path) || fs_create(path, FT_DIR)) {
+                ndirs++;
+            } else {
+                printf("initramfs: mkdir %s failed\n", path);
+            }
+        } else if ((mode & S_IFMT) == S_IFREG) {
+            int r = mount_file(path, data, filesize);
+            if (r < 0) {
+                printf("initramfs: create %s failed\n", path);
+            } else if (r > 0) {
+                nfiles++;
+                bytes += filesize;
+            } else {
+                kept++;
+            }
+        }
+        end_op();
+    }
+    printf("initramfs: %d files (%d bytes, not copied), %d dirs, %d kept from disk\n",
+           nfiles, (int)bytes, ndirs, kept);
+}
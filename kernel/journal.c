@@ -0,0 +1,265 @@
+// kernel/journal.c
+// 带组提交的元数据日志
+//
+// 每个文件系统操作以 begin_op/end_op 包围，其间修改的元数据块用 log_write 记录并钉在页缓存中。
+// 多个进程的操作累积在同一个事务里，到下列时机才一次性提交：
+//   - 事务已持续 journal_interval 个时钟中断（提交线程 journal_task）
+//   - 日志剩余空间不足以容纳新操作
+//   - sync（mkfs 也用它落盘）
+// 提交顺序：写回数据块 -> 日志块 -> 日志头（提交点）-> 原位置 -> 清空日志头
+#include "journal.h"
+#include "printf.h"
+#include "string.h"
+#include "proc/proc.h"
+
+enum { COMMIT_NONE, COMMIT_TIMER, COMMIT_SPACE, COMMIT_SYNC };
+
+static struct {
+    uint start;            // 日志头块号，日志块紧随其后
+    int cap;               // 可容纳的日志块数
+    int outstanding;       // 正在执行的操作数
+    int committing;
+    int closing;           // 非 0 时新操作等待，最后一个 end_op 提交（值为提交原因）
+    int nops;              // 当前事务包含的操作数
+    int age;               // 当前事务已持续的时钟中断数
+    struct logheader lh;
+    struct buf *bufs[LOGHDR_MAX];   // 与 lh.block 对应的钉住的缓存块
+} log;
+
+static int journal_interval = LOG_COMMIT_TICKS;
+static char kick;          // 提交线程的睡眠通道
+struct journal_stats journal_stats;
+
+static void write_head(void) {
+    struct buf *b = bread(log.start);
+    memcpy(b->data, &log.lh, sizeof(log.lh));
+    blk_rw(&b, 1, 1);
+    brelse(b);
+}
+
+// 启动时重放已提交但未写回原位置的事务
+static void recover(void) {
+    struct buf *b = bread(log.start);
+    memcpy(&log.lh, b->data, sizeof(log.lh));
+    brelse(b);
+
+    if (log.lh.n > (uint)log.cap) {
+        printf("journal: bad log header (n=%d), ignored\n", log.lh.n);
+        log.lh.n = 0;
+    }
+    for (uint i = 0; i < log.lh.n; i++) {
+        struct buf *lb = bread(log.start + 1 + i);
+        struct buf *hb = bget_zero(log.lh.block[i]);
+        memcpy(hb->data, lb->data, BSIZE);
+        blk_rw(&hb, 1, 1);
+        brelse(lb);
+        brelse(hb);
+    }
+    if (log.lh.n) {
+        printf("journal: replayed %d blocks\n", log.lh.n);
+    }
+    log.lh.n = 0;
+    write_head();
+}
+
+void journal_init(uint start, uint size) {
+    log.start = start;
+    log.cap = size - 1;
+    if (log.cap > LOGHDR_MAX) log.cap = LOGHDR_MAX;
+    if (log.cap < MAXOPBLOCKS) {
+        printf("journal_init: log too small (%d blocks)\n", size);
+    }
+    recover();
+    printf("journal_init: %d log blocks at %d, commit interval %d ticks\n",
+           log.cap, log.start, journal_interval);
+}
+
+// 提交当前事务；调用者保证没有进行中的操作
+static void commit(int reason) {
+    int n = log.lh.n;
+
+    if (n > 0) {
+        // ordered：数据块先于引用它们的元数据落盘
+        bsync();
+
+        // 日志块：一次提交，块层合并成连续的大请求
+        static struct buf *lbs[LOGHDR_MAX];
+        for (int i = 0; i < n; i++) {
+            lbs[i] = bget_zero(log.start + 1 + i);
+            memcpy(lbs[i]->data, log.bufs[i]->data, BSIZE);
+        }
+        blk_rw(lbs, n, 1);
+        for (int i = 0; i < n; i++) {
+            brelse(lbs[i]);
+        }
+
+        write_head();  // 提交点
+
+        // 写回原位置并解除钉住
+        blk_rw(log.bufs, n, 1);
+        for (int i = 0; i < n; i++) {
+            log.bufs[i]->dirty = 0;
+            bunpin(log.bufs[i]);
+            log.bufs[i] = 0;
+        }
+        log.lh.n = 0;
+        write_head();
+
+        journal_stats.commits++;
+        journal_stats.ops += log.nops;
+        journal_stats.blocks += n;
+        if (log.nops > journal_stats.max_ops) journal_stats.max_ops = log.nops;
+        if (n > journal_stats.max_blocks) journal_stats.max_blocks = n;
+        if (reason == COMMIT_TIMER) journal_stats.by_timer++;
+        else if (reason == COMMIT_SPACE) journal_stats.by_space++;
+        else journal_stats.by_sync++;
+    }
+    log.nops = 0;
+    log.age = 0;
+}
+
+// 在调用者上下文中提交；调用时中断已关闭且 outstanding 为 0
+static void do_commit(int reason) {
+    log.committing = 1;
+    commit(reason);
+    log.committing = 0;
+    log.closing = COMMIT_NONE;
+    wakeup(&log);
+}
+
+// 请求提交：阻止新操作加入，进行中的操作全部结束后提交
+static void request_commit(int reason) {
+    if (log.closing == COMMIT_NONE) {
+        log.closing = reason;
+    }
+    if (log.outstanding == 0 && !log.committing) {
+        do_commit(log.closing);
+    }
+}
+
+void begin_op(void) {
+    int intr = intr_get();
+    intr_off();
+
+    while (1) {
+        if (log.committing || log.closing) {
+            sleep(&log);
+        } else if (log.lh.n + (log.outstanding + 1) * MAXOPBLOCKS > log.cap) {
+            // 日志可能装不下：等进行中的操作结束后提交
+            request_commit(COMMIT_SPACE);
+            if (log.closing || log.committing) {
+                sleep(&log);
+            }
+        } else {
+            if (log.nops++ == 0) {
+                log.age = 0;
+            }
+            log.outstanding++;
+            break;
+        }
+    }
+
+    if (intr) {
+        intr_on();
+    }
+}
+
+void end_op(void) {
+    int intr = intr_get();
+    intr_off();
+
+    if (--log.outstanding == 0) {
+        // 调度器启动前的操作（initramfs 挂载等）也留在事务里，由提交线程稍后一起提交
+        if (log.closing) {
+            do_commit(log.closing);
+        } else if (log.lh.n + 2 * MAXOPBLOCKS > log.cap) {
+            do_commit(COMMIT_SPACE);
+        }
+    }
+    wakeup(&log);
+
+    if (intr) {
+        intr_on();
+    }
+}
+
+// 记录本操作修改了 b（代替 bwrite）；同一事务中重复修改同一块只占一个日志槽
+void log_write(struct buf *b) {
+    int intr = intr_get();
+    intr_off();
+
+    if (log.outstanding < 1) {
+        printf("log_write: block %d outside of a transaction\n", b->blockno);
+    }
+
+    int i;
+    for (i = 0; i < log.lh.n; i++) {
+        if (log.lh.block[i] == b->blockno) break;
+    }
+    if (i < log.lh.n) {
+        journal_stats.absorbed++;
+    } else if (log.lh.n < log.cap) {
+        log.lh.block[log.lh.n] = b->blockno;
+        log.bufs[log.lh.n] = b;
+        log.lh.n++;
+        bpin(b);
+    } else {
+        printf("log_write: transaction too big, block %d written unlogged\n", b->blockno);
+        bwrite(b);
+    }
+
+    if (intr) {
+        intr_on();
+    }
+}
+
+// 提交当前事务并写回所有脏块
+void journal_sync(void) {
+    int intr = intr_get();
+    intr_off();
+
+    if (log.nops > 0 || log.lh.n > 0) {
+        request_commit(COMMIT_SYNC);
+        while (log.closing || log.committing) {
+            sleep(&log);
+        }
+    }
+    bsync();
+
+    if (intr) {
+        intr_on();
+    }
+}
+
+// 时钟中断中调用：事务到期后唤醒提交线程
+void journal_tick(void) {
+    if (log.nops > 0 && ++log.age >= journal_interval) {
+        wakeup(&kick);
+    }
+}
+
+void journal_set_interval(int ticks) {
+    journal_interval = ticks > 0 ? ticks : 1;
+}
+
+// 提交线程：把一个时间窗口内所有进程的操作合并成一次提交
+void journal_task(void) {
+    intr_off();
+    while (1) {
+        while (log.nops == 0 || log.age < journal_interval || log.closing || log.committing) {
+            sleep(&kick);
+        }
+        request_commit(COMMIT_TIMER);
+    }
+}
+
+void journal_stats_dump(void) {
+    uint64_t c = journal_stats.commits ? journal_stats.commits : 1;
+    printf("journal: %d commits (timer %d, space %d, sync %d), %d ops, %d blocks, %d absorbed\n",
+           (int)journal_stats.commits, (int)journal_stats.by_timer,
+           (int)journal_stats.by_space, (int)journal_stats.by_sync,
+           (int)journal_stats.ops, (int)journal_stats.blocks, (int)journal_stats.absorbed);
+    printf("journal: per commit avg %d ops / %d blocks, max %d ops / %d blocks\n",
+           (int)(journal_stats.ops / c), (int)(journal_stats.blocks / c),
+           journal_stats.max_ops, journal_stats.max_blocks);
+}
@@ -0,0 +1,88 @@
+// kernel/klog.c
+// 内核日志环：klog 用 fetch_add 取得序号，直接把格式化结果写进对应槽位，不持锁
+// 读者按序号顺序遍历，槽位的 seq 与期望不符（正在写入或已被覆盖）就跳过
+#include "klog.h"
+#include "printf.h"
+#include "string.h"
+
+static struct klog_rec klog_ring[KLOG_NREC];
+static uint64_t klog_next;                 // 下一条记录的序号
+static int klog_console_level = KLOG_INFO;
+
+static const char klog_tag[] = "DIWE";     // dmesg 中的级别标记
+
+void klog(int level, const char *fmt, ...) {
+    uint64_t seq = __atomic_fetch_add(&klog_next, 1, __ATOMIC_RELAXED);
+    struct klog_rec *r = &klog_ring[seq & (KLOG_NREC - 1)];
+    va_list ap;
+
+    __atomic_store_n(&r->seq, 0, __ATOMIC_RELAXED);
+    r->time = r_time();
+    r->level = level;
+    va_start(ap, fmt);
+    vsnprintf(r->msg, KLOG_MSG, fmt, ap);
+    va_end(ap);
+    __atomic_store_n(&r->seq, seq + 1, __ATOMIC_RELEASE);
+
+    if (level >= __atomic_load_n(&klog_console_level, __ATOMIC_RELAXED)) {
+        printf("%s", r->msg);
+    }
+}
+
+// 设置控制台级别，返回原级别；level < 0 时只查询
+int klog_set_level(int level) {
+    if (level < 0) {
+        return klog_console_level;
+    }
+    if (level > KLOG_ERR) {
+        level = KLOG_ERR;
+    }
+    return __atomic_exchange_n(&klog_console_level, level, __ATOMIC_RELAXED);
+}
+
+// 把序号为 seq 的记录格式化为 "[秒.微秒] L 正文\n"；记录无效（正在写入或已被覆盖）返回 -1
+static int format_rec(char *buf, int size, uint64_t seq) {
+    struct klog_rec *r = &klog_ring[seq & (KLOG_NREC - 1)];
+    struct klog_rec copy;
+
+    if (__atomic_load_n(&r->seq, __ATOMIC_ACQUIRE) != seq + 1) return -1;
+    copy = *r;
+    if (__atomic_load_n(&r->seq, __ATOMIC_ACQUIRE) != seq + 1) return -1;  // 复制时被覆盖
+
+    uint64_t us = copy.time / (TIMEBASE_FREQ / 1000000);
+    int l = strlen(copy.msg);
+    return snprintf(buf, size, "[%5lu.%06lu] %c %s%s",
+                    us / 1000000, us % 1000000, klog_tag[copy.level & 3], copy.msg,
+                    l && copy.msg[l - 1] == '\n' ? "" : "\n");  // 被截断的记录补上换行
+}
+
+// 按时间顺序把环中的记录写入 buf，放不下时丢弃最旧的，只写完整的行
+// 返回写入的字节数（不含结尾 0）
+int klog_read(char *buf, int len) {
+    uint64_t end = __atomic_load_n(&klog_next, __ATOMIC_ACQUIRE);
+    uint64_t first = end > KLOG_NREC ? end - KLOG_NREC : 0;
+    uint64_t seq = end;
+    int total = 0, n = 0;
+
+    if (buf == 0 || len <= 0) return -1;
+
+    // 从最新的记录往回数，找出能放进 buf 的最早一条
+    while (seq > first) {
+        int m = format_rec(0, 0, seq - 1);
+        if (m > 0 && total + m >= len) break;
+        if (m > 0) total += m;
+        seq--;
+    }
+
+    buf[0] = 0;
+    for (; seq < end; seq++) {
+        int m = format_rec(buf + n, len - n, seq);
+        if (m < 0) continue;
+        if (m >= len - n) {
+            buf[n] = 0;  // 两次遍历之间有记录变长（被新记录覆盖），整行丢弃
+            break;
+        }
+        n += m;
+    }
+    return n;
+}
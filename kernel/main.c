@@ -8,6 +8,19 @@ void uart_puts(char *s);
 #include "mm/pmm.h"
 #include "mm/vm.h"
 #include "trap/trap.h"
+#include "uring.h"
+#include "vdso.h"
+#include "bench.h"
+#include "syscall.h"
+#include "fs.h"
+#include "journal.h"
+#include "initramfs.h"
+#include "blk/blk.h"
+#include "klog.h"
+#include "cpu.h"
+#include "fdt.h"
+#include "prof.h"
+#include "perf.h"
 #include <assert.h>
 #include <string.h>
 _Static_assert(1, "proc.h included successfully");
@@ -17,6 +30,14 @@ void task2(void);
 void task3(void);
 void user_task(void);        // ✅ 声明
 void fs_test_task(void);     // ✅ 声明
+void thread_test_task(void);
+void exec_test_task(void);
+void exec_lazy_task(void);
+void uring_test_task(void);
+void iov_test_task(void);
+void klog_test_task(void);
+void prof_test_task(void);
+void perf_test_task(void);
 
 
 // 测试任务1
@@ -69,9 +90,19 @@ void test_printf_basic() {
 
 void test_printf_edge_cases() {
     printf("INT_MAX: %d\n", 2147483647);
-    printf("INT_MIN: %d\n", -2147483648);
+    printf("INT_MIN: %d\n", -2147483647 - 1);
     printf("NULL string: %s\n", (char*)0);
     printf("Empty string: %s\n", "");
+    printf("INT64_MIN: %ld\n", (int64_t)0x8000000000000000ULL);
+    printf("UINT64_MAX: %lu 0x%llx\n", ~0UL, ~0ULL);
+    printf("size_t: %zu\n", sizeof(struct proc));
+    printf("64-bit pointer: %p\n", (void*)0xffffffc080001234ULL);
+    printf("Padding: [%5d] [%-5d] [%05d] [%08lx] [%*s] [%-4s] [%.3s]\n",
+           42, 42, -42, 0xbeefUL, 6, "abc", "ab", "truncate");
+
+    char buf[8];
+    int n = snprintf(buf, sizeof(buf), "%d-%s", 12345, "overflow");
+    printf("snprintf truncation: \"%s\" (needed %d)\n", buf, n);
 }
 
 void test_physical_memory(void) {
@@ -167,10 +198,372 @@ void fs_test_task(void) {
 
     // 删除文件
     unlink("/test.txt");
+
+    // 稀疏大文件：只有写入过的页占用内存
+    fd = open("/sparse.bin", 1);
+    pwrite(fd, msg, strlen(msg), 4 * 1024 * 1024);
+    struct inode *ip = namei("/sparse.bin");
+    n = pread(fd, buf, 16, 4096);  // 空洞读出为 0
+    printf("Sparse file: size=%d pages=%d hole=%d\n", (int)ip->size, (int)ip->npages, buf[0]);
+    if (ip->npages != 1 || n != 16 || buf[0] != 0) {
+        printf("Sparse file test failed\n");
+        exit(1);
+    }
+    close(fd);
+    unlink("/sparse.bin");
+
+    // 多级目录
+    if (mkdir("/a") < 0 || mkdir("/a/b") < 0) {
+        printf("mkdir failed\n");
+        exit(1);
+    }
+    fd = open("/a/b/c.txt", 1);
+    write(fd, msg, strlen(msg));
+    close(fd);
+    fd = open("/a/./b/../b/c.txt", 0);
+    n = read(fd, buf, sizeof(buf) - 1);
+    close(fd);
+    buf[n < 0 ? 0 : n] = '\0';
+    printf("Nested read: %s", buf);
+    if (rmdir("/a/b") == 0 || rmdir("/a") == 0) {  // 非空目录不能删除
+        printf("rmdir of non-empty directory succeeded\n");
+        exit(1);
+    }
+    unlink("/a/b/c.txt");
+    if (rmdir("/a/b") < 0 || rmdir("/a") < 0 || namei("/a")) {
+        printf("rmdir failed\n");
+        exit(1);
+    }
+    // dup 共享偏移；关闭后最小的 fd 被复用
+    fd = open("/dup.txt", 1);
+    int fd2 = dup(fd);
+    write(fd, "ab", 2);
+    write(fd2, "cd", 2);
+    n = pread(fd, buf, 4, 0);
+    buf[4] = '\0';
+    close(fd);
+    int fd3 = open("/dup.txt", 0);
+    printf("dup: fd=%d fd2=%d reopened=%d data=%s\n", fd, fd2, fd3, buf);
+    if (fd2 != fd + 1 || fd3 != fd || n != 4 || strcmp(buf, "abcd") != 0) {
+        printf("dup test failed\n");
+        exit(1);
+    }
+    close(fd2);
+    close(fd3);
+    unlink("/dup.txt");
+
+    // initramfs：内容直接读自内核镜像，第一次写入时才复制到磁盘块
+    fd = open("/etc/motd", 0);
+    ip = namei("/etc/motd");
+    if (fd < 0 || ip == 0) {
+        printf("initramfs: /etc/motd missing\n");
+        exit(1);
+    }
+    char motd[16], again[16];
+    int xip = ip->xip != 0;
+    n = pread(fd, motd, sizeof(motd), 0);
+    pwrite(fd, motd, n, 0);  // 原样写回：触发复制，内容不变
+    int m = pread(fd, again, sizeof(again), 0);
+    int same = m == n;
+    for (int i = 0; same && i < n; i++) {
+        same = motd[i] == again[i];
+    }
+    close(fd);
+    printf("initramfs: /etc/motd xip=%d -> %d, %d pages on disk\n",
+           xip, ip->xip != 0, (int)ip->npages);
+    if (n <= 0 || !same || ip->xip) {
+        printf("initramfs copy-up test failed\n");
+        exit(1);
+    }
+
+    // 持久化：启动计数保存在磁盘上，每次 make run 加 1（ramdisk 时总是 1）
+    int boots = 0;
+    if ((fd = open("/bootcount", 0)) < 0) {
+        fd = open("/bootcount", 1);
+    }
+    pread(fd, &boots, sizeof(boots), 0);
+    boots++;
+    pwrite(fd, &boots, sizeof(boots), 0);
+    close(fd);
+    sync();
+    printf("Boot count: %d\n", boots);
     printf("Filesystem test completed.\n");
     exit(0);
 }
 
+// ========== 线程 + futex 测试 ==========
+#define THREAD_ITERS 2000
+
+static struct umutex counter_lock;
+static int shared_counter;
+static char thread_stacks[2][PGSIZE] __attribute__((aligned(16)));
+
+static void counter_thread(void *arg) {
+    for (int i = 0; i < THREAD_ITERS; i++) {
+        umutex_lock(&counter_lock);
+        int v = shared_counter;
+        for (volatile int j = 0; j < 50; j++);  // 拉长临界区，制造竞争
+        shared_counter = v + 1;
+        umutex_unlock(&counter_lock);
+    }
+    printf("Thread %d (arg %d) done\n", getpid(), (int)(uint64_t)arg);
+}
+
+void thread_test_task(void) {
+    int tid[2];
+
+    printf("Starting thread test...\n");
+    umutex_init(&counter_lock);
+    shared_counter = 0;
+
+    for (int i = 0; i < 2; i++) {
+        if (thread_create(counter_thread, (void*)(uint64_t)i,
+                          thread_stacks[i] + PGSIZE, &tid[i]) < 0) {
+            printf("thread_create failed\n");
+            exit(1);
+        }
+    }
+    thread_join(&tid[0]);
+    thread_join(&tid[1]);
+
+    if (shared_counter != 2 * THREAD_ITERS) {
+        printf("Thread test failed: counter = %d\n", shared_counter);
+        exit(1);
+    }
+    printf("✅ Thread test passed: counter = %d\n", shared_counter);
+    exit(0);
+}
+
+// ========== exec 测试：用 ELF 程序替换当前任务 ==========
+void exec_test_task(void) {
+    static char *argv[] = { "hello", "from", "exec", 0 };
+
+    printf("Starting exec test...\n");
+    exec("/hello", argv);
+    printf("exec failed!\n");
+    exit(1);
+}
+
+void exec_lazy_task(void) {
+    static char *argv[] = { "lazy", 0 };
+    exec("/lazy", argv);
+    printf("exec failed!\n");
+    exit(1);
+}
+
+// ========== readv/writev/pread/pwrite 测试 ==========
+void iov_test_task(void) {
+    char hdr[] = "HDR:";
+    char payload[] = "payload bytes\n";
+    char a[4], b[16];
+
+    printf("Starting iov test...\n");
+    int fd = open("/iov.txt", 1);
+    if (fd < 0) {
+        printf("open failed!\n");
+        exit(1);
+    }
+
+    // 头部 + 负载：一次 trap 写入
+    struct iovec wv[2] = {
+        { hdr, 4 },
+        { payload, sizeof(payload) - 1 },
+    };
+    int n = writev(fd, wv, 2);
+    printf("writev wrote %d bytes\n", n);
+
+    // 定位读：不依赖也不修改共享偏移
+    struct iovec rv[2] = {
+        { a, sizeof(a) },
+        { b, sizeof(payload) - 1 },
+    };
+    int m = pread(fd, a, sizeof(a), 0);
+    if (m != 4 || a[0] != 'H' || a[3] != ':') {
+        printf("pread failed (%d)\n", m);
+        exit(1);
+    }
+    close(fd);
+
+    fd = open("/iov.txt", 0);
+    m = readv(fd, rv, 2);
+    if (m != n || b[0] != 'p') {
+        printf("readv failed (%d)\n", m);
+        exit(1);
+    }
+
+    // sendfile：文件内容直接写到控制台，不经过用户缓冲区
+    m = sendfile(1, fd, 0, n);
+    if (m != n) {
+        printf("sendfile failed (%d)\n", m);
+        exit(1);
+    }
+    close(fd);
+    unlink("/iov.txt");
+    printf("✅ iov test passed\n");
+    exit(0);
+}
+
+// ========== 提交/完成环测试：比较批量提交与逐个系统调用的 trap 次数 ==========
+#define URING_RECORDS 64
+
+static const char uring_record[] = "ring record 16\n";  // 16 字节（含换行）
+
+static int write_records_syscall(void) {
+    int fd = open("/ring_a.txt", 1);
+    if (fd < 0) return -1;
+    for (int i = 0; i < URING_RECORDS; i++) {
+        write(fd, uring_record, 16);
+    }
+    close(fd);
+    return 0;
+}
+
+static int write_records_uring(struct uring *r) {
+    struct uring_sqe *sqe = uring_get_sqe(r);
+    struct uring_cqe *cqe;
+
+    sqe->opcode = URING_OP_OPEN;
+    sqe->addr = (uint64_t)"/ring_b.txt";
+    sqe->len = 1;  // O_CREATE
+    sqe->user_data = 0;
+    uring_advance_sq(r);
+    ring_enter(uring_sq_pending(r));
+
+    cqe = uring_peek_cqe(r);
+    int fd = cqe ? cqe->res : -1;
+    if (cqe) uring_cqe_seen(r);
+    if (fd < 0) return -1;
+
+    // 写操作按 SQ 容量成批提交，最后一批带上 close
+    for (int i = 0; i <= URING_RECORDS; ) {
+        while (i <= URING_RECORDS && (sqe = uring_get_sqe(r)) != 0) {
+            sqe->fd = fd;
+            sqe->user_data = i + 1;
+            if (i < URING_RECORDS) {
+                sqe->opcode = URING_OP_WRITE;
+                sqe->addr = (uint64_t)uring_record;
+                sqe->len = 16;
+            } else {
+                sqe->opcode = URING_OP_CLOSE;
+            }
+            uring_advance_sq(r);
+            i++;
+        }
+        ring_enter(uring_sq_pending(r));
+        while ((cqe = uring_peek_cqe(r)) != 0) {
+            if (cqe->res < 0) {
+                printf("uring op %d failed\n", (int)cqe->user_data);
+            }
+            uring_cqe_seen(r);
+        }
+    }
+    return 0;
+}
+
+void uring_test_task(void) {
+    struct uring *r;
+
+    printf("Starting uring test...\n");
+    if (ring_setup(&r) < 0) {
+        printf("ring_setup failed\n");
+        exit(1);
+    }
+
+    uint64_t before = current_proc->nsyscall;
+    write_records_syscall();
+    uint64_t syscall_traps = current_proc->nsyscall - before;
+
+    before = current_proc->nsyscall;
+    write_records_uring(r);
+    uint64_t uring_traps = current_proc->nsyscall - before;
+
+    printf("uring: %d writes, syscall path %d traps, ring path %d traps\n",
+           URING_RECORDS, (int)syscall_traps, (int)uring_traps);
+
+    unlink("/ring_a.txt");
+    unlink("/ring_b.txt");
+    exit(0);
+}
+
+// 内核日志：调试级别的记录不上控制台，但能从 dmesg 取回
+void klog_test_task(void) {
+    static char buf[4096];
+    const char *key = "klog_test: quiet";
+
+    int old = loglevel(KLOG_INFO);
+    klog(KLOG_DEBUG, "%s %d\n", key, getpid());
+    int n = dmesg(buf, sizeof(buf));
+
+    int found = 0, lines = 0;
+    for (int i = 0; i < n && !found; i++) {
+        if (buf[i] == '\n') lines++;
+        int j = 0;
+        while (key[j] && buf[i + j] == key[j]) j++;
+        found = key[j] == 0;
+    }
+    printf("klog: dmesg returned %d bytes, %s debug record after %d lines\n",
+           n, found ? "found" : "MISSING", lines);
+    loglevel(old);
+    exit(0);
+}
+
+// 采样 profiler：高频采样一段忙循环，样本应落在本进程上
+// 已由启动参数开启采样时不打扰它
+void prof_test_task(void) {
+    if (prof(PROF_START, PROF_HZ_MAX) < 0) {
+        printf("prof_test: profiler busy, skipped\n");
+        exit(0);
+    }
+    uint64_t t0 = r_time();
+    while (r_time() - t0 < TIMEBASE_FREQ / 20) {
+        ;
+    }
+    int n = prof(PROF_STOP, 0);
+    printf("prof_test: %d samples in 50 ms at %d Hz (%s)\n", n, PROF_HZ_MAX, n > 0 ? "ok" : "FAILED");
+    prof(PROF_RESET, 0);
+    exit(0);
+}
+
+// 溢出采样（样本进入 profiler 的采样表）：忙循环期间应至少溢出一次
+// 返回 1 为通过，0 为不支持（需要 SBI PMU 与 Sscofpmf）而跳过，-1 为没有样本
+static int perf_sample_check(void) {
+    if (perf_sample(PERF_INSTRET, PERF_SAMPLE_PERIOD / 10) < 0) {
+        printf("perf_test: no counter overflow interrupts, sampling skipped\n");
+        return 0;
+    }
+    for (volatile int i = 0; i < 200000; i++);
+    int n = perf_sample(PERF_INSTRET, 0);
+    printf("perf_test: %d instret overflow samples (%s)\n", n, n > 0 ? "ok" : "FAILED");
+    return n > 0 ? 1 : -1;
+}
+
+// 硬件计数器：忙循环前后各读一次本进程的计数，打印 IPC 与缓存缺失
+void perf_test_task(void) {
+    uint64_t c0[PERF_NEVENTS], c1[PERF_NEVENTS];
+
+    int mask = perf_read(0, c0, PERF_NEVENTS);
+    for (volatile int i = 0; i < 200000; i++);
+    perf_read(0, c1, PERF_NEVENTS);
+    if (mask <= 0) {
+        printf("perf_test: no hardware counters\n");
+        exit(0);
+    }
+
+    uint64_t cyc = c1[PERF_CYCLES] - c0[PERF_CYCLES];
+    uint64_t ins = c1[PERF_INSTRET] - c0[PERF_INSTRET];
+    printf("perf_test: pid %d: %lu cycles, %lu instructions", getpid(), cyc, ins);
+    if (cyc && (mask & (1 << PERF_INSTRET))) {
+        printf(", IPC %lu.%02lu", ins / cyc, ins * 100 / cyc % 100);
+    }
+    if (mask & (1 << PERF_CACHE_MISSES)) {
+        printf(", %lu cache misses", c1[PERF_CACHE_MISSES] - c0[PERF_CACHE_MISSES]);
+    }
+    printf(" (%s)\n", (mask & (1 << PERF_INSTRET)) && ins == 0 ? "FAILED" : "ok");
+
+    perf_sample_check();
+    exit(0);
+}
+
 // ========== 用户态任务：测试系统调用 ==========
 void user_task(void) {
     int pid = getpid();
@@ -182,34 +575,125 @@ void user_task(void) {
     exit(0);
 }
 
+// ========== 启动计时 ==========
+// 各阶段结束时的 rdtime；_entry 的时刻由 entry.S 在清零 BSS 后写入
+uint64_t boot_time_entry;
+uint64_t boot_hartid;   // QEMU 在 a0 中传入
+uint64_t boot_dtb;      // QEMU 在 a1 中传入的设备树地址
+
+#define BOOT_PHASES 16
+static struct {
+    const char *name;
+    uint64_t time;
+} boot_phases[BOOT_PHASES];
+static int nboot_phases;
+
+static void boot_mark(const char *name) {
+    if (nboot_phases < BOOT_PHASES) {
+        boot_phases[nboot_phases].name = name;
+        boot_phases[nboot_phases].time = r_time();
+        nboot_phases++;
+    }
+}
+
+static uint64_t boot_us(uint64_t t) {
+    return t * 1000000 / TIMEBASE_FREQ;
+}
+
+void boot_report_task(void) {
+    boot_mark("first task");
+    printf("boot timing (rdtime, us):\n");
+    printf("  %-14s %8s %8s\n", "phase", "delta", "total");
+    uint64_t prev = boot_time_entry;
+    for (int i = 0; i < nboot_phases; i++) {
+        printf("  %-14s %8lu %8lu\n", boot_phases[i].name,
+               boot_us(boot_phases[i].time - prev), boot_us(boot_phases[i].time - boot_time_entry));
+        prev = boot_phases[i].time;
+    }
+    exit(0);
+}
+
+#ifdef BENCH
+// make bench 构建的内核：不跑功能测试，只跑基准测试，然后经 test finisher 退出 QEMU
+// BENCH_REV 由 Makefile 传入（git 版本），用于区分各次运行的结果
+#ifndef BENCH_REV
+#define BENCH_REV "unknown"
+#endif
+
+static void bench_main_task(void) {
+    int failed = bench_suite(BENCH_REV);
+    if (perf_sample_check() < 0) {
+        failed = 1;
+    }
+    bench_all();
+    if (prof_ctl(PROF_STOP, 0) >= 0) {
+        prof_dump();  // make bench BOOTARGS=prof：整个基准测试期间的采样
+    }
+    machine_exit(failed ? 1 : 0);
+}
+#endif
+
 int main() {
+    boot_mark("bss clear");   // _entry 到这里：BSS 清零
+    fdt_init(boot_dtb);       // 内存大小与设备地址，uart_init 也要用
     uart_init();
     clear_screen();
     goto_xy(5, 3);
     set_color(32); // 绿色
     printf("🚀 RISC-V MiniOS - Process & Scheduling Lab\n");
     reset_color();
+    fdt_dump();
+    boot_mark("uart_init");
 
     // 基础测试
     test_printf_basic();
     test_printf_edge_cases();
+    boot_mark("printf tests");
 
     // 内存与页表初始化
     pmm_init();
+    boot_mark("pmm_init");
     test_physical_memory();
     test_pagetable();
+    boot_mark("memory tests");
 
     kvminit();
+    vdso_init();
     kvminithart();
+    boot_mark("kvminit");
 
     // 中断系统初始化
     trap_init();
+    cpu_probe();
+    perf_init();
+    boot_mark("trap_init");
 
     // ✅ 关键：初始化进程系统
     proc_init();
+    boot_mark("proc_init");
+
+    // 磁盘文件系统（没有 virtio 磁盘时用 ramdisk），再挂上链接进内核的 initramfs（/hello、/lazy、/etc/motd ...）
+    fs_init();
+    boot_mark("fs_init");
+    initramfs_mount();
+    boot_mark("initramfs");
 
     printf("\n✅ Creating processes...\n");
 
+    // 第一个被调度的进程：记录到第一个任务的时间并打印启动时间表
+    create_process(boot_report_task);
+
+#ifdef BENCH
+    create_process(journal_task);
+    create_process(bflush_task);
+    create_process(bench_main_task);
+    prof_init();
+#else
+    // 启动参数 prof[=hz]：从这里开始采样，采样结束后由 prof_task 输出
+    if (prof_init()) {
+        create_process(prof_task);
+    }
+
     // ✅ 创建多个进程
     if (create_process(task1) <= 0) {
         printf("Failed to create task1\n");
@@ -222,10 +706,22 @@ int main() {
     }
     
 
+    create_process(journal_task);  // 日志提交线程：按间隔合并提交各进程的元数据修改
+    create_process(bflush_task);   // 回写线程：把脏页聚成大批次写回
     create_process(user_task);  // 创建用户态任务
     create_process(fs_test_task);
+    create_process(thread_test_task);
+    create_process(exec_test_task);
+    create_process(exec_lazy_task);
+    create_process(uring_test_task);
+    create_process(iov_test_task);
+    create_process(klog_test_task);
+    create_process(prof_test_task);
+    create_process(perf_test_task);
+#endif
 
     printf("✅ All processes created. Starting scheduler...\n");
+    boot_mark("create tasks");
 
     // ✅ 启动调度器（永不返回）
     scheduler();
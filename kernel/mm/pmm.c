@@ -2,7 +2,10 @@
 #include "riscv.h"
 #include "printf.h"
 #include "mm/pmm.h"
-extern char end[];
+#include "string.h"
+#include "fdt.h"
+// 链接脚本：end 是 BSS 的结束，启动栈（stack_bottom..stack_top）紧随其后，_end 在栈之后
+extern char _end[];
 
 // 空闲页链表节点
 struct run {
@@ -12,26 +15,57 @@ struct run {
 // 空闲页链表头
 static struct run *freelist;
 
-// 初始化物理内存管理器
+// 每页的引用数：alloc_page 置 1，写时复制共享时增加，free_page 减到 0 才真正释放
+// 数组覆盖设备树报告的全部内存，放在内核映像与启动栈之后，大小随内存而定
+// 16 位：同一页可以同时挂在全部 NPIPE × PIPE_BUFS 个管道槽位上，再加上映射它的页表就超过 255
+static uint16_t *pgref;
+static uint64_t pgref_base;    // 最低的物理内存地址
+static uint64_t pgref_top;     // 最高的物理内存地址（不含）
+static uint64_t pmm_start;     // 内核映像与 pgref 之后第一个可分配的页
+
+#define PGREF(pa) pgref[((uint64_t)(pa) - pgref_base) / PGSIZE]
+
+static int pmm_reserved(uint64_t p) {
+    if (p >= KERNBASE && p < pmm_start) return 1;
+    for (int i = 0; i < machine.nresv; i++) {
+        if (p >= machine.resv[i].base && p < machine.resv[i].base + machine.resv[i].size) return 1;
+    }
+    return 0;
+}
+
+// 初始化物理内存管理器：设备树中的每段内存除去内核、pgref 与保留区后全部可分配
 void pmm_init(void) {
-    // 可用物理内存范围：从 _end 到 PHYSTOP
-    extern char end[];  // 由链接脚本定义
-    uint64_t start = PGROUNDUP((uint64_t)end);
-    uint64_t stop = PHYSTOP;
+    pgref_base = ~0UL;
+    pgref_top = 0;
+    for (int i = 0; i < machine.nmem; i++) {
+        if (machine.mem[i].base < pgref_base) pgref_base = PGROUNDDOWN(machine.mem[i].base);
+    }
+    pgref_top = PGROUNDUP(machine_ram_end());
+    uint64_t npages = (pgref_top - pgref_base) / PGSIZE;
+    // 不能从 end 开始：那里是 main 仍在使用的启动栈
+    pgref = (uint16_t*)PGROUNDUP((uint64_t)_end);
+    memset(pgref, 0, npages * sizeof(*pgref));
+    pmm_start = PGROUNDUP((uint64_t)(pgref + npages));
 
-    printf("pmm_init: memory range [0x%p - 0x%p]\n", start, stop);
+    printf("pmm_init: memory range [0x%lx - 0x%lx], %lu KB of page refcounts\n",
+           pgref_base, pgref_top, (npages * sizeof(*pgref)) >> 10);
 
-    // 按页倒序插入空闲链表（简单实现）
+    // 按页倒序插入空闲链表，低地址的页先被分配
     freelist = 0;
-    int page_count = 0;
-    for (uint64_t p = stop - PGSIZE; p >= start; p -= PGSIZE) {
-        struct run *r = (struct run *)p;
-        r->next = freelist;
-        freelist = r;
-        page_count++;
-        if (p == start) break; // 防止死循环
+    uint64_t page_count = 0;
+    for (int i = machine.nmem - 1; i >= 0; i--) {
+        uint64_t lo = PGROUNDUP(machine.mem[i].base);
+        uint64_t hi = PGROUNDDOWN(machine.mem[i].base + machine.mem[i].size);
+        for (uint64_t p = hi; p > lo; ) {
+            p -= PGSIZE;
+            if (pmm_reserved(p)) continue;
+            struct run *r = (struct run *)p;
+            r->next = freelist;
+            freelist = r;
+            page_count++;
+        }
     }
-    printf("pmm_init: total pages = %d\n", page_count);
+    printf("pmm_init: total pages = %lu (%lu MB)\n", page_count, page_count >> 8);
 }
 
 // 分配一页物理内存
@@ -42,18 +76,33 @@ void* alloc_page(void) {
     }
     struct run *r = freelist;
     freelist = freelist->next;
+    PGREF(r) = 1;
     return (void*)r;
 }
 
+// 增加一个引用（页被多个页表或管道共享）
+void page_dup(void *pa) {
+    PGREF(pa)++;
+}
+
+int page_refcnt(void *pa) {
+    return PGREF(pa);
+}
+
 
 // 释放一页物理内存
 void free_page(void *pa) {
-    extern char end[];  // ✅ 添加这一行！声明 end 符号
+    uint64_t p = (uint64_t)pa;
 
-    if (((uint64_t)pa % PGSIZE) != 0 || (char*)pa < (char*)PGROUNDUP((uint64_t)&end)) {
-        printf("free_page: invalid address 0x%p\n", pa);
+    if ((p % PGSIZE) != 0 || p < pgref_base || p >= pgref_top || pmm_reserved(p)) {
+        printf("free_page: invalid address %p\n", pa);
+        return;
+    }
+    if (PGREF(pa) > 1) {
+        PGREF(pa)--;  // 还有其他使用者
         return;
     }
+    PGREF(pa) = 0;
 
     struct run *r = (struct run *)pa;
     r->next = freelist;
@@ -3,6 +3,9 @@
 #include "mm/pmm.h"
 #include "printf.h"
 #include "mm/vm.h"
+#include "string.h"
+#include "klog.h"
+#include "fdt.h"
 extern char etext[], end[];
 
 // 创建新页表（分配根页表）
@@ -12,40 +15,38 @@ pagetable_t create_pagetable(void) {
         printf("create_pagetable: failed\n");
         return 0;
     }
-    for (int i = 0; i < 512; i++) {
-        pt[i] = 0;
-    }
+    page_zero(pt);
     return pt;
 }
 
-// 页表遍历（查找或创建）
-static pte_t* walk(pagetable_t pt, uint64_t va, int alloc) {
-    for (int level = 2; level >= 0; level--) {
-        uint64_t vpn = VPN_MASK(va, level);
-        pte_t *pte = &pt[vpn];
-        
+// 页表遍历（查找或创建），返回第 leaf 级的页表项
+// 途中遇到大页叶子（R/W/X 不全为 0）时直接返回它
+static pte_t* walk_level(pagetable_t pt, uint64_t va, int alloc, int leaf) {
+    for (int level = 2; level > leaf; level--) {
+        pte_t *pte = &pt[VPN_MASK(va, level)];
+
         if (*pte & PTE_V) {
-            if (level == 0) return pte;  // 找到叶子
+            if (*pte & (PTE_R | PTE_W | PTE_X)) return pte;
             pt = (pagetable_t)PTE2PPN(*pte);
         } else {
             if (!alloc) return 0;
             pagetable_t new_pt = (pagetable_t)alloc_page();
             if (new_pt == 0) return 0;
-            for (int i = 0; i < 512; i++) {
-                new_pt[i] = 0;
-            }
+            page_zero(new_pt);
             *pte = PPN2PTE((uint64_t)new_pt) | PTE_V;
             pt = new_pt;
         }
     }
-    // 问题可能在这里：循环结束后没有返回有效的 pte
-    // 对于 level=0 的情况，即使创建了新页表项，也需要返回它
-    return &pt[VPN_MASK(va, 0)];  // 返回最后一级的 pte
+    return &pt[VPN_MASK(va, leaf)];
+}
+
+static pte_t* walk(pagetable_t pt, uint64_t va, int alloc) {
+    return walk_level(pt, va, alloc, 0);
 }
 
 // 映射一页：va → pa
 int map_page(pagetable_t pt, uint64_t va, uint64_t pa, int perm) {
-    printf("map_page: va=0x%lx, pa=0x%lx, perm=0x%x\n", va, pa, perm);
+    klog(KLOG_DEBUG, "map_page: va=0x%lx, pa=0x%lx, perm=0x%x\n", va, pa, perm);
     if ((va % PGSIZE) != 0 || (pa % PGSIZE) != 0) {
         printf("map_page: addresses not aligned\n");
         return -1;
@@ -58,12 +59,11 @@ int map_page(pagetable_t pt, uint64_t va, uint64_t pa, int perm) {
     }
 
     if (*pte & PTE_V) {
-        printf("map_page: va 0x%p already mapped\n", va);
+        printf("map_page: va 0x%lx already mapped\n", va);
         return -1;
     }
 
     *pte = PPN2PTE(pa) | perm | PTE_V;
-    printf("map_page: mapped successfully\n");
     return 0;
 }
 
@@ -71,7 +71,7 @@ int map_page(pagetable_t pt, uint64_t va, uint64_t pa, int perm) {
 void destroy_pagetable(pagetable_t pt) {
     if (pt == 0) return;
     for (int i = 0; i < 512; i++) {
-        if (pt[i] & PTE_V && (pt[i] & (PTE_R | PTE_W | PTE_X)) != 0) {
+        if (pt[i] & PTE_V && (pt[i] & (PTE_R | PTE_W | PTE_X)) == 0) {
             // 是中间页表，递归销毁
             destroy_pagetable((pagetable_t)PTE2PPN(pt[i]));
         }
@@ -84,7 +84,7 @@ void dump_pagetable(pagetable_t pt, int level) {
     if (pt == 0) return;
     for (int i = 0; i < 512; i++) {
         if (pt[i] & PTE_V) {
-            if (level > 0 && (pt[i] & (PTE_R | PTE_W | PTE_X)) != 0) {
+            if (level > 0 && (pt[i] & (PTE_R | PTE_W | PTE_X)) == 0) {
                 // 中间页表
                 dump_pagetable((pagetable_t)PTE2PPN(pt[i]), level - 1);
             } else {
@@ -105,7 +105,25 @@ void dump_pagetable(pagetable_t pt, int level) {
 // 全局内核页表
 pagetable_t kernel_pagetable;
 
-// 初始化内核页表
+// 内核恒等映射 [pa, pa + size)：2MB 对齐的部分用大页，几 GB 内存也只需要少量页表页
+static int kvmmap(uint64_t pa, uint64_t size, int perm) {
+    uint64_t stop = pa + size;
+
+    while (pa < stop) {
+        if (pa % MEGAPAGE == 0 && stop - pa >= MEGAPAGE) {
+            pte_t *pte = walk_level(kernel_pagetable, pa, 1, 1);
+            if (pte == 0 || (*pte & PTE_V)) return -1;
+            *pte = PPN2PTE(pa) | perm | PTE_V;
+            pa += MEGAPAGE;
+        } else {
+            if (map_page(kernel_pagetable, pa, pa, perm) < 0) return -1;
+            pa += PGSIZE;
+        }
+    }
+    return 0;
+}
+
+// 初始化内核页表：内核代码只读可执行，其余全部物理内存可读写，外加设备寄存器
 void kvminit(void) {
     printf("kvminit: creating kernel page table...\n");
 
@@ -115,64 +133,183 @@ void kvminit(void) {
         return;
     }
 
-    extern char etext[], end[];
+    uint64_t text_end = PGROUNDUP((uint64_t)etext);
+    if (kvmmap(KERNBASE, text_end - KERNBASE, PTE_R | PTE_X) < 0) {
+        printf("kvminit: failed to map kernel text\n");
+        return;
+    }
 
-    // 映射内核代码段（R+X）
-    for (uint64_t va = KERNBASE; va < (uint64_t)etext; va += PGSIZE) {
-        uint64_t pa = va;
-        // 添加地址对齐检查
-        if ((va % PGSIZE) != 0 || (pa % PGSIZE) != 0) {
-            printf("kvminit: code address not aligned: va=0x%lx, pa=0x%lx\n", va, pa);
-            continue;
+    // 内存段可能包含内核：去掉代码部分，分成代码前后两段
+    for (int i = 0; i < machine.nmem; i++) {
+        uint64_t lo = PGROUNDDOWN(machine.mem[i].base);
+        uint64_t hi = PGROUNDUP(machine.mem[i].base + machine.mem[i].size);
+        uint64_t cut_lo = lo < KERNBASE ? KERNBASE : lo;
+        uint64_t cut_hi = hi < text_end ? hi : text_end;
+        int r = 0;
+        if (cut_lo < cut_hi) {
+            if (lo < cut_lo) r |= kvmmap(lo, cut_lo - lo, PTE_R | PTE_W);
+            if (cut_hi < hi) r |= kvmmap(cut_hi, hi - cut_hi, PTE_R | PTE_W);
+        } else {
+            r = kvmmap(lo, hi - lo, PTE_R | PTE_W);
         }
-        if (map_page(kernel_pagetable, va, pa, PTE_R | PTE_X) < 0) {
-            printf("kvminit: failed to map code at 0x%lx\n", va);
+        if (r < 0) {
+            printf("kvminit: failed to map memory 0x%lx - 0x%lx\n", lo, hi);
             return;
         }
     }
 
-    // 映射内核数据段（R+W）
-    // 修复：确保起始地址页对齐
-    uint64_t data_start = PGROUNDUP((uint64_t)etext);
-    for (uint64_t va = data_start; va < PGROUNDUP((uint64_t)end); va += PGSIZE) {
-        uint64_t pa = va;
-        // 添加地址对齐检查
-        if ((va % PGSIZE) != 0 || (pa % PGSIZE) != 0) {
-            printf("kvminit: data address not aligned: va=0x%lx, pa=0x%lx\n", va, pa);
-            continue;
+    // 映射 UART、virtio MMIO 槽位、PLIC 用到的寄存器页与 test finisher（R+W）
+    if (map_page(kernel_pagetable, PGROUNDDOWN(machine.uart), PGROUNDDOWN(machine.uart), PTE_R | PTE_W) < 0) {
+        printf("kvminit: failed to map UART\n");
+        return;
+    }
+    for (int i = 0; i < machine.nvirtio; i++) {
+        if (map_page(kernel_pagetable, machine.virtio[i].base, machine.virtio[i].base, PTE_R | PTE_W) < 0) {
+            printf("kvminit: failed to map virtio\n");
+            return;
         }
-        if (map_page(kernel_pagetable, va, pa, PTE_R | PTE_W) < 0) {
-            printf("kvminit: failed to map data at 0x%lx\n", va);
+    }
+    uint64_t plic_pages[] = { 0, 0x2000, 0x201000 };  // 优先级、使能、阈值/claim
+    for (int i = 0; i < 3; i++) {
+        uint64_t pa = machine.plic + plic_pages[i];
+        if (map_page(kernel_pagetable, pa, pa, PTE_R | PTE_W) < 0) {
+            printf("kvminit: failed to map PLIC\n");
             return;
         }
     }
+    if (machine.finisher &&
+        map_page(kernel_pagetable, PGROUNDDOWN(machine.finisher), PGROUNDDOWN(machine.finisher), PTE_R | PTE_W) < 0) {
+        printf("kvminit: failed to map test finisher\n");
+        return;
+    }
+
+    printf("kvminit: kernel page table created successfully\n");
+}
+
+// 查找 va 对应的物理地址，未映射返回 0
+uint64_t walkaddr(pagetable_t pt, uint64_t va) {
+    pte_t *pte = walk(pt, va, 0);
+    if (pte == 0 || (*pte & PTE_V) == 0) {
+        return 0;
+    }
+    return PTE2PPN(*pte) | (va & (PGSIZE - 1));
+}
 
-    // 映射栈空间（预留 4MB）
-    for (uint64_t va = 0x87c00000; va < 0x88000000; va += PGSIZE) {
-        uint64_t pa = va;
-        // 添加地址对齐检查
-        if ((va % PGSIZE) != 0 || (pa % PGSIZE) != 0) {
-            printf("kvminit: stack address not aligned: va=0x%lx, pa=0x%lx\n", va, pa);
+// 创建用户页表：共享内核的根页表项，用户空间（根页表第 1 项）为空
+pagetable_t uvmcreate(void) {
+    pagetable_t pt = create_pagetable();
+    if (pt == 0) {
+        return 0;
+    }
+    for (int i = 0; i < 512; i++) {
+        if (i != USER_ROOT_INDEX) {
+            pt[i] = kernel_pagetable[i];
+        }
+    }
+    return pt;
+}
+
+// 递归释放用户空间的页表页和叶子物理页
+static void uvmfree_level(pagetable_t pt, int level) {
+    for (int i = 0; i < 512; i++) {
+        pte_t pte = pt[i];
+        if ((pte & PTE_V) == 0) {
             continue;
         }
-        if (map_page(kernel_pagetable, va, pa, PTE_R | PTE_W) < 0) {
-            printf("kvminit: failed to map stack at 0x%lx\n", va);
-            return;
+        if (level > 0 && (pte & (PTE_R | PTE_W | PTE_X)) == 0) {
+            uvmfree_level((pagetable_t)PTE2PPN(pte), level - 1);
+        } else if ((pte & PTE_U) && !(pte & PTE_SHARED)) {
+            free_page((void*)PTE2PPN(pte));
         }
+        pt[i] = 0;
     }
+    free_page(pt);
+}
 
-    // 映射 UART 设备（R+W）
-    // 添加地址对齐检查
-    if ((UART0 % PGSIZE) != 0) {
-        printf("kvminit: UART address not aligned: 0x%lx\n", UART0);
-    } else {
-        if (map_page(kernel_pagetable, UART0, UART0, PTE_R | PTE_W) < 0) {
-            printf("kvminit: failed to map UART\n");
-            return;
-        }
+// 释放用户页表（内核共享部分不动）
+void uvmfree(pagetable_t pt) {
+    if (pt == 0) return;
+    pte_t pte = pt[USER_ROOT_INDEX];
+    if (pte & PTE_V) {
+        uvmfree_level((pagetable_t)PTE2PPN(pte), 1);
     }
+    free_page(pt);
+}
 
-    printf("kvminit: kernel page table created successfully\n");
+// 放弃一个使用者对用户页表的引用：同组线程共享页表，根页表页的引用计数就是使用者数，
+// 最后一个使用者才释放整棵页表
+void uvmput(pagetable_t pt) {
+    if (pt == 0) return;
+    if (page_refcnt(pt) > 1) {
+        free_page(pt);  // 只减少引用
+        return;
+    }
+    uvmfree(pt);
+}
+
+// 内核（SUM）按 write 方式访问用户页 va 时会不会缺页：0 表示会
+int uvm_accessible(pagetable_t pt, uint64_t va, int write) {
+    pte_t *pte = walk(pt, va, 0);
+    if (pte == 0 || (*pte & (PTE_V | PTE_U)) != (PTE_V | PTE_U)) return 0;
+    return write ? (*pte & PTE_W) != 0 : (*pte & PTE_R) != 0;
+}
+
+// ================= 写时复制 =================
+// 页在页表之间（经管道）移交时不复制：双方都映射为只读 + PTE_COW，
+// 谁先写谁在缺页中得到私有副本；只剩一个使用者时直接恢复可写
+
+// 用户页 va 变为写时复制并增加一个引用，返回其物理地址；不能共享时返回 0
+uint64_t uvm_share(pagetable_t pt, uint64_t va) {
+    pte_t *pte = walk(pt, va, 0);
+    if (pte == 0 || (*pte & (PTE_V | PTE_U)) != (PTE_V | PTE_U) || (*pte & PTE_SHARED)) {
+        return 0;
+    }
+    if (*pte & PTE_W) {
+        *pte = (*pte & ~PTE_W) | PTE_COW;
+        sfence_vma();
+    }
+    uint64_t pa = PTE2PPN(*pte);
+    page_dup((void*)pa);
+    return pa;
+}
+
+// 用物理页 pa 替换 va 处已有的可写用户页（接管调用者持有的 pa 引用）
+// 新映射为写时复制；va 未映射或不可写时返回 -1
+int uvm_remap(pagetable_t pt, uint64_t va, uint64_t pa) {
+    pte_t *pte = walk(pt, va, 0);
+    if (pte == 0 || (*pte & (PTE_V | PTE_U)) != (PTE_V | PTE_U) || (*pte & PTE_SHARED)) {
+        return -1;
+    }
+    if ((*pte & (PTE_W | PTE_COW)) == 0) {
+        return -1;
+    }
+    uint64_t old = PTE2PPN(*pte);
+    int flags = (*pte & 0x3FF & ~PTE_W) | PTE_COW;
+    *pte = PPN2PTE(pa) | flags;
+    sfence_vma();
+    free_page((void*)old);
+    return 0;
+}
+
+// 写缺页：va 是写时复制页时处理并返回 0，否则返回 -1
+int uvm_cow(pagetable_t pt, uint64_t va) {
+    pte_t *pte = walk(pt, va, 0);
+    if (pte == 0 || (*pte & PTE_V) == 0 || (*pte & PTE_COW) == 0) {
+        return -1;
+    }
+    uint64_t pa = PTE2PPN(*pte);
+    int flags = (*pte & 0x3FF & ~PTE_COW) | PTE_W;
+
+    if (page_refcnt((void*)pa) > 1) {
+        char *mem = alloc_page();
+        if (mem == 0) return -1;
+        memcpy(mem, (void*)pa, PGSIZE);
+        free_page((void*)pa);  // 只是减少引用
+        pa = (uint64_t)mem;
+    }
+    *pte = PPN2PTE(pa) | flags;
+    sfence_vma();
+    return 0;
 }
 
 // 在当前 hart 上启用页表
@@ -0,0 +1,248 @@
+// kernel/perf.c
+// 硬件性能计数器：经 SBI PMU 扩展分配与启动计数器，按进程虚拟化，
+// 计数器溢出中断（Sscofpmf）用作 profiler 的采样源
+// 没有 SBI PMU 时退回到直接读 cycle/instret（需要固件在 scounteren 中开放）
+#include "riscv.h"
+#include "printf.h"
+#include "string.h"
+#include "perf.h"
+#include "prof.h"
+#include "cpu.h"
+#include "trap/trap.h"
+#include "proc/proc.h"
+
+#define SBI_EXT_BASE            0x10
+#define SBI_BASE_PROBE_EXT      3
+#define SBI_EXT_PMU             0x504d55   // "PMU"
+#define SBI_PMU_NUM_COUNTERS    0
+#define SBI_PMU_COUNTER_INFO    1
+#define SBI_PMU_COUNTER_CONFIG  2
+#define SBI_PMU_COUNTER_START   3
+#define SBI_PMU_COUNTER_STOP    4
+#define SBI_PMU_COUNTER_FW_READ 5
+
+#define PMU_CFG_CLEAR_VALUE  (1 << 1)
+#define PMU_CFG_AUTO_START   (1 << 2)
+#define PMU_CFG_SET_MINH     (1 << 7)   // 不计 M 模式（固件）里的事件
+#define PMU_START_SET_INIT   (1 << 0)
+#define PMU_STOP_RESET       (1 << 0)   // 停止并释放计数器
+
+struct perf_counter {
+    int present;
+    int idx;        // SBI 计数器编号，直接读 CSR 时为 -1
+    int csr;        // 0xc00 + n；0 表示固件计数器，只能经 SBI 读
+    int width;      // 位数
+};
+
+// SBI 通用硬件事件编号（事件类型 0）
+static const struct {
+    const char *name;
+    int sbi_event;
+} perf_events[PERF_NEVENTS] = {
+    [PERF_CYCLES]        = { "cycles", 1 },
+    [PERF_INSTRET]       = { "instret", 2 },
+    [PERF_CACHE_REFS]    = { "cache_refs", 3 },
+    [PERF_CACHE_MISSES]  = { "cache_misses", 4 },
+    [PERF_BRANCH_MISSES] = { "branch_misses", 6 },
+};
+
+static struct perf_counter counters[PERF_NEVENTS];
+static int perf_pmu;            // 有 SBI PMU 扩展
+static int perf_ncounters;
+static uint64_t perf_used;      // 已分配的 SBI 计数器位图
+static int perf_mask;           // 可用事件位图（perf_read 的返回值）
+
+// 溢出采样用的计数器（与计数用的分开，重新装初值不影响按进程的计数）
+static struct perf_counter sample_counter;
+static int sample_event = -1;
+static uint64_t sample_init;
+static int sample_count;        // 本次采样以来的溢出样本数
+
+const char *perf_event_name(int event) {
+    return event >= 0 && event < PERF_NEVENTS ? perf_events[event].name : "?";
+}
+
+// csrr 的 CSR 编号必须是立即数：0xc00..0xc1f 逐个展开
+#define CSR_READ_CASE(n) case 0xc00 + n: asm volatile("csrr %0, %1" : "=r" (x) : "i" (0xc00 + n)); break;
+
+static uint64_t read_counter_csr(int csr) {
+    uint64_t x = 0;
+    switch (csr) {
+    CSR_READ_CASE(0)  CSR_READ_CASE(1)  CSR_READ_CASE(2)  CSR_READ_CASE(3)
+    CSR_READ_CASE(4)  CSR_READ_CASE(5)  CSR_READ_CASE(6)  CSR_READ_CASE(7)
+    CSR_READ_CASE(8)  CSR_READ_CASE(9)  CSR_READ_CASE(10) CSR_READ_CASE(11)
+    CSR_READ_CASE(12) CSR_READ_CASE(13) CSR_READ_CASE(14) CSR_READ_CASE(15)
+    CSR_READ_CASE(16) CSR_READ_CASE(17) CSR_READ_CASE(18) CSR_READ_CASE(19)
+    CSR_READ_CASE(20) CSR_READ_CASE(21) CSR_READ_CASE(22) CSR_READ_CASE(23)
+    CSR_READ_CASE(24) CSR_READ_CASE(25) CSR_READ_CASE(26) CSR_READ_CASE(27)
+    CSR_READ_CASE(28) CSR_READ_CASE(29) CSR_READ_CASE(30) CSR_READ_CASE(31)
+    }
+    return x;
+}
+
+static uint64_t counter_read(struct perf_counter *c) {
+    if (!c->present) return 0;
+    if (c->csr) return read_counter_csr(c->csr);
+    return sbi_call(SBI_EXT_PMU, SBI_PMU_COUNTER_FW_READ, c->idx, 0, 0, 0, 0).value;
+}
+
+// 让 SBI 从尚未使用的计数器中挑一个能数 sbi_event 的，并按 flags 配置
+static int pmu_alloc(int sbi_event, uint64_t flags, struct perf_counter *c) {
+    uint64_t mask = perf_ncounters >= 64 ? ~0UL : (1UL << perf_ncounters) - 1;
+    struct sbiret r = sbi_call(SBI_EXT_PMU, SBI_PMU_COUNTER_CONFIG, 0, mask & ~perf_used,
+                               flags | PMU_CFG_SET_MINH, sbi_event, 0);
+    if (r.error || r.value < 0 || r.value >= 64) return -1;
+
+    // info：[11:0] CSR 编号，[17:12] 位数 - 1，[63] 为 1 表示固件计数器
+    struct sbiret info = sbi_call(SBI_EXT_PMU, SBI_PMU_COUNTER_INFO, r.value, 0, 0, 0, 0);
+    c->present = 1;
+    c->idx = r.value;
+    c->csr = 0;
+    c->width = 64;
+    if (info.error == 0 && info.value >= 0) {
+        c->csr = info.value & 0xfff;
+        c->width = ((info.value >> 12) & 0x3f) + 1;
+    }
+    perf_used |= 1UL << c->idx;
+    return 0;
+}
+
+// 没有 SBI PMU：cycle/instret 能否直接读取（读不了是非法指令，由 kerneltrap 跳过）
+static int probe_csr(int csr) {
+    cpu_probing = 1;
+    read_counter_csr(csr);
+    int ok = cpu_probing == 1;
+    cpu_probing = 0;
+    return ok;
+}
+
+// 需要在 cpu_probe 之后调用（探测依赖 kerneltrap 跳过非法指令）
+// M 模式下没有 SBI，不能用 ecall 探测 PMU 扩展（会陷入未设置的 mtvec 而挂住）
+void perf_init(void) {
+    if (!cpu_mmode) {
+        struct sbiret r = sbi_call(SBI_EXT_BASE, SBI_BASE_PROBE_EXT, SBI_EXT_PMU, 0, 0, 0, 0);
+        perf_pmu = r.error == 0 && r.value != 0;
+    }
+
+    if (perf_pmu) {
+        perf_ncounters = sbi_call(SBI_EXT_PMU, SBI_PMU_NUM_COUNTERS, 0, 0, 0, 0, 0).value;
+        for (int e = 0; e < PERF_NEVENTS; e++) {
+            if (pmu_alloc(perf_events[e].sbi_event, PMU_CFG_CLEAR_VALUE | PMU_CFG_AUTO_START, &counters[e]) == 0) {
+                perf_mask |= 1 << e;
+            }
+        }
+    } else {
+        static const int fixed[][2] = { { PERF_CYCLES, 0xc00 }, { PERF_INSTRET, 0xc02 } };
+        for (int i = 0; i < 2; i++) {
+            if (probe_csr(fixed[i][1])) {
+                struct perf_counter *c = &counters[fixed[i][0]];
+                c->present = 1;
+                c->idx = -1;
+                c->csr = fixed[i][1];
+                c->width = 64;
+                perf_mask |= 1 << fixed[i][0];
+            }
+        }
+    }
+
+    printf("perf_init: %s", perf_pmu ? "SBI PMU" : cpu_mmode ? "no SBI (M mode), fixed counters only" : "no SBI PMU, fixed counters only");
+    if (perf_pmu) {
+        printf(" (%d counters)", perf_ncounters);
+    }
+    printf(":");
+    for (int e = 0; e < PERF_NEVENTS; e++) {
+        if (perf_mask & (1 << e)) printf(" %s", perf_events[e].name);
+    }
+    printf("\n");
+}
+
+// 调度器切换到 p 之前：记下各计数器的当前值
+void perf_switch_in(struct proc *p) {
+    for (int e = 0; e < PERF_NEVENTS; e++) {
+        p->perf_base[e] = counter_read(&counters[e]);
+    }
+}
+
+// p 让出 CPU 回到调度器之后：把这段时间的增量记到 p 上
+void perf_switch_out(struct proc *p) {
+    for (int e = 0; e < PERF_NEVENTS; e++) {
+        p->perf_count[e] += counter_read(&counters[e]) - p->perf_base[e];
+    }
+}
+
+// 读出 p 的前 n 个事件的累计值；p 是当前进程时包括本次运行到现在的部分
+// 返回可用事件的位图，不可用的事件读出为 0
+int perf_counts(struct proc *p, uint64_t *counts, int n) {
+    if (n > PERF_NEVENTS) n = PERF_NEVENTS;
+    for (int e = 0; e < n; e++) {
+        counts[e] = p->perf_count[e];
+        if (p == current_proc) {
+            counts[e] += counter_read(&counters[e]) - p->perf_base[e];
+        }
+    }
+    return perf_mask;
+}
+
+static void sample_restart(void) {
+    sbi_call(SBI_EXT_PMU, SBI_PMU_COUNTER_STOP, sample_counter.idx, 1, 0, 0, 0);
+    sbi_call(SBI_EXT_PMU, SBI_PMU_COUNTER_START, sample_counter.idx, 1, PMU_START_SET_INIT, sample_init, 0);
+}
+
+// 每 period 个 event 产生一次溢出中断，在中断里记一个 profiler 样本；
+// period 为 0 时停止，返回这次采样记下的样本数
+// 需要 SBI PMU 与 Sscofpmf（没有时 sie.LCOFIE 只读为 0）
+int perf_set_sampling(int event, uint64_t period) {
+    int intr = intr_get();
+    int r = 0;
+
+    intr_off();
+    if (period == 0) {
+        if (sample_event < 0) {
+            r = -1;
+        } else {
+            sbi_call(SBI_EXT_PMU, SBI_PMU_COUNTER_STOP, sample_counter.idx, 1, PMU_STOP_RESET, 0, 0);
+            perf_used &= ~(1UL << sample_counter.idx);
+            w_sie(r_sie() & ~SIE_LCOFIE);
+            sample_event = -1;
+            r = sample_count;
+        }
+    } else if (!perf_pmu || event < 0 || event >= PERF_NEVENTS || sample_event >= 0) {
+        r = -1;
+    } else {
+        memset(&sample_counter, 0, sizeof(sample_counter));
+        w_sie(r_sie() | SIE_LCOFIE);
+        if (!(r_sie() & SIE_LCOFIE) ||
+            pmu_alloc(perf_events[event].sbi_event, PMU_CFG_CLEAR_VALUE, &sample_counter) < 0 ||
+            sample_counter.csr == 0) {
+            if (sample_counter.present) {
+                sbi_call(SBI_EXT_PMU, SBI_PMU_COUNTER_STOP, sample_counter.idx, 1, PMU_STOP_RESET, 0, 0);
+                perf_used &= ~(1UL << sample_counter.idx);
+            }
+            memset(&sample_counter, 0, sizeof(sample_counter));
+            w_sie(r_sie() & ~SIE_LCOFIE);
+            r = -1;
+        } else {
+            // 从 2^width - period 开始数，数满 period 个事件时溢出
+            uint64_t top = sample_counter.width >= 64 ? 0 : 1UL << sample_counter.width;
+            sample_init = top - period;
+            sample_event = event;
+            sample_count = 0;
+            sbi_call(SBI_EXT_PMU, SBI_PMU_COUNTER_START, sample_counter.idx, 1, PMU_START_SET_INIT, sample_init, 0);
+        }
+    }
+    if (intr) {
+        intr_on();
+    }
+    return r;
+}
+
+// 计数器溢出中断（scause = 中断 13）：记样本并重新装初值，重启时 SBI 会清掉溢出标志
+void perf_overflow(struct trapframe *tf, uint64_t sstatus) {
+    uint64_t ovf = r_scountovf();
+    w_sip(r_sip() & ~SIP_LCOFIP);
+    if (sample_event >= 0 && (ovf & (1UL << (sample_counter.csr - 0xc00)))) {
+        prof_record(tf, sstatus);
+        sample_count++;
+        sample_restart();
+    }
+}
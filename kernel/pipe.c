@@ -0,0 +1,195 @@
+// kernel/pipe.c
+// 管道：读写在 sleep/wakeup 通道上阻塞，读者等 &p->head（有数据），写者等 &p->tail（有空槽）
+// 整页的读写经写时复制移交物理页，见 include/pipe.h
+#include "pipe.h"
+#include "file.h"
+#include "printf.h"
+#include "string.h"
+#include "mm/pmm.h"
+#include "mm/vm.h"
+#include "proc/proc.h"
+#include "klog.h"
+
+static struct pipe pipes[NPIPE];
+
+// 已关闭的管道的累计统计，pipe_stats_dump 输出
+static struct {
+    uint64_t closed;
+    uint64_t copied;
+    uint64_t handoff;
+    uint64_t remapped;
+} pipe_totals;
+
+int pipealloc(struct file **rf, struct file **wf) {
+    struct pipe *p = 0;
+    for (int i = 0; i < NPIPE; i++) {
+        if (!pipes[i].used) {
+            p = &pipes[i];
+            break;
+        }
+    }
+    if (p == 0) {
+        printf("pipealloc: no free pipes\n");
+        return -1;
+    }
+
+    *rf = filealloc();
+    *wf = *rf ? filealloc() : 0;
+    if (*wf == 0) {
+        if (*rf) fileclose(*rf);
+        return -1;
+    }
+
+    memset(p, 0, sizeof(*p));
+    p->used = 1;
+    p->readopen = 1;
+    p->writeopen = 1;
+    (*rf)->type = FD_PIPE;
+    (*rf)->pipe = p;
+    (*rf)->readable = 1;
+    (*wf)->type = FD_PIPE;
+    (*wf)->pipe = p;
+    (*wf)->writable = 1;
+    return 0;
+}
+
+// 关闭一端；两端都关闭后释放剩余的页
+void pipeclose(struct pipe *p, int writable) {
+    int intr = intr_get();
+    intr_off();
+
+    if (writable) {
+        p->writeopen = 0;
+        wakeup(&p->head);   // 读者看到 EOF
+    } else {
+        p->readopen = 0;
+        wakeup(&p->tail);   // 写者得到错误
+    }
+    if (!p->readopen && !p->writeopen) {
+        for (; p->head != p->tail; p->head++) {
+            free_page(p->bufs[p->head % PIPE_BUFS].page);
+        }
+        pipe_totals.closed++;
+        pipe_totals.copied += p->copied;
+        pipe_totals.handoff += p->handoff;
+        pipe_totals.remapped += p->remapped;
+        klog(KLOG_DEBUG, "pipe: closed, %lu bytes copied, %lu pages handed off, %lu remapped\n",
+             p->copied, p->handoff, p->remapped);
+        p->used = 0;
+    }
+
+    if (intr) {
+        intr_on();
+    }
+}
+
+// 输出到目前为止已关闭的管道的累计统计
+void pipe_stats_dump(void) {
+    printf("pipe: %lu closed, %lu bytes copied, %lu pages handed off, %lu remapped\n",
+           pipe_totals.closed, pipe_totals.copied, pipe_totals.handoff, pipe_totals.remapped);
+}
+
+// 当前进程的用户页 va 能否参与页移交
+static int user_page(uint64_t va) {
+    return current_proc && current_proc->pagetable && va % PGSIZE == 0 &&
+           va >= USERBASE && va < USERTOP;
+}
+
+// 写满 n 字节才返回（读端关闭时返回已写的字节数，一个都没写时返回 -1）
+int pipe_write(struct pipe *p, const char *src, int n) {
+    int i = 0;
+    int intr = intr_get();
+    intr_off();
+
+    while (i < n) {
+        if (!p->readopen) {
+            break;
+        }
+        int nbufs = p->tail - p->head;
+        struct pipe_buf *last = nbufs ? &p->bufs[(p->tail - 1) % PIPE_BUFS] : 0;
+        int room = last && !last->gift ? PGSIZE - (last->off + last->len) : 0;
+
+        // 整页：把写者的页以写时复制方式挂进管道
+        if (n - i >= PGSIZE && nbufs < PIPE_BUFS && user_page((uint64_t)(src + i))) {
+            uint64_t pa = uvm_share(current_proc->pagetable, (uint64_t)(src + i));
+            if (pa) {
+                struct pipe_buf *b = &p->bufs[p->tail++ % PIPE_BUFS];
+                b->page = (char*)pa;
+                b->off = 0;
+                b->len = PGSIZE;
+                b->gift = 1;
+                p->handoff++;
+                i += PGSIZE;
+                wakeup(&p->head);
+                continue;
+            }
+        }
+
+        if (room == 0) {
+            if (nbufs == PIPE_BUFS) {
+                wakeup(&p->head);
+                sleep(&p->tail);
+                continue;
+            }
+            char *page = alloc_page();
+            if (page == 0) break;
+            last = &p->bufs[p->tail++ % PIPE_BUFS];
+            last->page = page;
+            last->off = 0;
+            last->len = 0;
+            last->gift = 0;
+            room = PGSIZE;
+        }
+        int m = n - i < room ? n - i : room;
+        memcpy(last->page + last->off + last->len, src + i, m);
+        last->len += m;
+        p->copied += m;
+        i += m;
+    }
+    wakeup(&p->head);
+
+    if (intr) {
+        intr_on();
+    }
+    return i == 0 && !p->readopen ? -1 : i;
+}
+
+// 管道空时阻塞到有数据或写端全部关闭（返回 0）；之后取走能立即读到的数据
+int pipe_read(struct pipe *p, char *dst, int n) {
+    int i = 0;
+    int intr = intr_get();
+    intr_off();
+
+    while (p->head == p->tail && p->writeopen) {
+        sleep(&p->head);
+    }
+    while (i < n && p->head != p->tail) {
+        struct pipe_buf *b = &p->bufs[p->head % PIPE_BUFS];
+
+        // 完整的一页且读者缓冲区页对齐：把这一页映射到读者的缓冲区
+        if (b->off == 0 && b->len == PGSIZE && n - i >= PGSIZE &&
+            user_page((uint64_t)(dst + i)) &&
+            uvm_remap(current_proc->pagetable, (uint64_t)(dst + i), (uint64_t)b->page) == 0) {
+            p->head++;
+            p->remapped++;
+            i += PGSIZE;
+            continue;
+        }
+
+        int m = n - i < b->len ? n - i : b->len;
+        memcpy(dst + i, b->page + b->off, m);
+        b->off += m;
+        b->len -= m;
+        i += m;
+        if (b->len == 0) {
+            free_page(b->page);
+            p->head++;
+        }
+    }
+    wakeup(&p->tail);
+
+    if (intr) {
+        intr_on();
+    }
+    return i;
+}
@@ -1,112 +1,204 @@
 // kernel/printf.c
+// vsnprintf 是唯一的格式化核心；printf 先渲染到栈上缓冲区，再整行写入控制台环
 #include "console.h"
-#include <stdarg.h>  // 可变参数
+#include "printf.h"
 
-// 前向声明
-static void printint(int xx, int base, int sign);
-static void printptr(unsigned long long x);
+#define PRINTBUF 256   // printf 单次输出上限，超出部分截断并以 "..." 结尾
 
-// 输出一个字符（供 printf 内部调用）
-static void putc(char c) {
-    console_putc(c);
+// 格式标志
+#define F_LEFT  (1 << 0)   // '-'：左对齐
+#define F_ZERO  (1 << 1)   // '0'：用 0 填充
+#define F_UPPER (1 << 2)   // %X
+
+// 输出目标：超出 size - 1 的字符只计数不写入，与 C 标准 snprintf 的返回值一致
+struct fmtbuf {
+    char *buf;
+    size_t size;
+    size_t n;
+};
+
+static void putc(struct fmtbuf *fb, char c) {
+    if (fb->n + 1 < fb->size) {
+        fb->buf[fb->n] = c;
+    }
+    fb->n++;
 }
 
-// 输出字符串
-static void puts(const char *s) {
-    console_puts(s);
+static void pad(struct fmtbuf *fb, char c, int n) {
+    while (n-- > 0) {
+        putc(fb, c);
+    }
 }
 
-// 核心 printf 实现
-int printf(const char *fmt, ...) {
-    va_list ap;
-    int i, c;
-    char *s;
-    int num;
+// 字符串：prec >= 0 时最多输出 prec 个字符
+static void puts(struct fmtbuf *fb, const char *s, int width, int prec, int flags) {
+    int len = 0;
 
-    va_start(ap, fmt);
-    for (i = 0; fmt[i]; i++) {
-        c = fmt[i];
+    if (s == 0) {
+        s = "(null)";
+    }
+    while (s[len] && (prec < 0 || len < prec)) {
+        len++;
+    }
+    if (!(flags & F_LEFT)) pad(fb, ' ', width - len);
+    for (int i = 0; i < len; i++) {
+        putc(fb, s[i]);
+    }
+    if (flags & F_LEFT) pad(fb, ' ', width - len);
+}
+
+// 整数：x 为绝对值，neg 表示需要负号；0 填充放在符号之后
+static void printint(struct fmtbuf *fb, uint64_t x, int base, int neg, int width, int flags) {
+    const char *digits = (flags & F_UPPER) ? "0123456789ABCDEF" : "0123456789abcdef";
+    char buf[24];  // 2^64 的十进制是 20 位
+    int i = 0;
 
+    do {
+        buf[i++] = digits[x % base];
+    } while ((x /= base) != 0);
+
+    int len = i + neg;
+    if (flags & F_LEFT) {
+        if (neg) putc(fb, '-');
+        while (--i >= 0) putc(fb, buf[i]);
+        pad(fb, ' ', width - len);
+    } else if (flags & F_ZERO) {
+        if (neg) putc(fb, '-');
+        pad(fb, '0', width - len);
+        while (--i >= 0) putc(fb, buf[i]);
+    } else {
+        pad(fb, ' ', width - len);
+        if (neg) putc(fb, '-');
+        while (--i >= 0) putc(fb, buf[i]);
+    }
+}
+
+// 支持 %[-0][width|*][.prec][l|ll|z](d|i|u|x|X|p|s|c|%)
+// 返回完整输出所需的长度（不含结尾 0），size 不为 0 时 buf 总以 0 结尾
+int vsnprintf(char *buf, size_t size, const char *fmt, va_list ap) {
+    struct fmtbuf fb = { buf, size, 0 };
+
+    for (int i = 0; fmt[i]; i++) {
+        char c = fmt[i];
         if (c != '%') {
-            putc(c);
+            putc(&fb, c);
             continue;
         }
 
-        c = fmt[++i]; // 取 % 后的字符
+        int flags = 0, width = 0, prec = -1, lng = 0;
+        for (;; i++) {
+            if (fmt[i + 1] == '-') flags |= F_LEFT;
+            else if (fmt[i + 1] == '0') flags |= F_ZERO;
+            else break;
+        }
+        if (fmt[i + 1] == '*') {
+            width = va_arg(ap, int);
+            if (width < 0) {
+                flags |= F_LEFT;
+                width = -width;
+            }
+            i++;
+        } else {
+            while (fmt[i + 1] >= '0' && fmt[i + 1] <= '9') {
+                width = width * 10 + (fmt[++i] - '0');
+            }
+        }
+        if (fmt[i + 1] == '.') {
+            i++;
+            prec = 0;
+            while (fmt[i + 1] >= '0' && fmt[i + 1] <= '9') {
+                prec = prec * 10 + (fmt[++i] - '0');
+            }
+        }
+        // 长度修饰：RV64 上 long、long long、size_t 都是 64 位
+        while (fmt[i + 1] == 'l' || fmt[i + 1] == 'z') {
+            lng = 1;
+            i++;
+        }
+
+        c = fmt[++i];
+        if (c == 0) break;  // 格式串以单独的 % 结尾
         switch (c) {
-        case 'd': // 有符号十进制
-            num = va_arg(ap, int);
-            printint(num, 10, 1);
+        case 'd':
+        case 'i': {
+            int64_t v = lng ? va_arg(ap, int64_t) : va_arg(ap, int);
+            // 取绝对值时先转无符号，INT64_MIN 也不会溢出
+            printint(&fb, v < 0 ? -(uint64_t)v : (uint64_t)v, 10, v < 0, width, flags);
+            break;
+        }
+        case 'u':
+            printint(&fb, lng ? va_arg(ap, uint64_t) : va_arg(ap, unsigned int), 10, 0, width, flags);
             break;
-        case 'x': // 无符号十六进制
-            num = va_arg(ap, int);
-            printint(num, 16, 0);
+        case 'X':
+            flags |= F_UPPER;
+            // fall through
+        case 'x':
+            printint(&fb, lng ? va_arg(ap, uint64_t) : va_arg(ap, unsigned int), 16, 0, width, flags);
             break;
-        case 'p': // 指针（十六进制）
-            printptr(va_arg(ap, unsigned long long));
+        case 'p': // 指针：完整 64 位
+            putc(&fb, '0');
+            putc(&fb, 'x');
+            printint(&fb, (uint64_t)va_arg(ap, void*), 16, 0, width > 2 ? width - 2 : 0, flags);
             break;
-        case 's': // 字符串
-            s = va_arg(ap, char*);
-            puts(s);
+        case 's':
+            puts(&fb, va_arg(ap, char*), width, prec, flags);
             break;
-        case 'c': // 字符
-            putc(va_arg(ap, int));
+        case 'c': {
+            char ch = va_arg(ap, int);
+            if (!(flags & F_LEFT)) pad(&fb, ' ', width - 1);
+            putc(&fb, ch);
+            if (flags & F_LEFT) pad(&fb, ' ', width - 1);
             break;
-        case '%': // 字面 %
-            putc('%');
+        }
+        case '%':
+            putc(&fb, '%');
             break;
         default:  // 未知格式符，原样输出
-            putc('%');
-            putc(c);
+            putc(&fb, '%');
+            putc(&fb, c);
             break;
         }
     }
-    va_end(ap);
-    return 0; // 简化，不返回字符数
-}
 
-// 打印整数（支持负数、不同进制）
-static void printint(int xx, int base, int sign) {
-    static char digits[] = "0123456789abcdef";
-    char buf[16];  // 足够存 int
-    int i = 0;
-    int neg = 0;
-    unsigned int x;
-
-    // 处理负数
-    if (sign && xx < 0) {
-        neg = 1;
-        x = -xx;  // 注意：-INT_MIN 会溢出！见下方说明
-    } else {
-        x = xx;
-    }
-
-    // 特殊处理 INT_MIN
-    if (sign && xx == 0x80000000) {
-        puts("-2147483648");
-        return;
+    if (size) {
+        buf[fb.n < size ? fb.n : size - 1] = 0;
     }
+    return fb.n;
+}
 
-    // 数字转字符串（逆序存入 buf）
-    do {
-        buf[i++] = digits[x % base];
-    } while ((x /= base) != 0);
+int snprintf(char *buf, size_t size, const char *fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(buf, size, fmt, ap);
+    va_end(ap);
+    return n;
+}
 
-    // 输出负号
-    if (neg) {
-        putc('-');
+// 渲染到栈上缓冲区后一次写入控制台环
+int vprintf(const char *fmt, va_list ap) {
+    char buf[PRINTBUF];
+    int n = vsnprintf(buf, sizeof(buf), fmt, ap);
+    if (n < PRINTBUF) {
+        console_write(buf, n);
+    } else {
+        console_write(buf, PRINTBUF - 5);
+        console_write("...\n", 4);
     }
+    return n;
+}
 
-    // 逆序输出
-    while (--i >= 0) {
-        putc(buf[i]);
-    }
+int printf(const char *fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vprintf(fmt, ap);
+    va_end(ap);
+    return n;
 }
 
-// 打印指针（16进制，带 0x 前缀）
-static void printptr(unsigned long long x) {
-    putc('0');
-    putc('x');
-    // 强制转为 32 位（RISC-V 32 位地址）
-    printint((int)x, 16, 0);
+// 致命错误：同步冲刷控制台环后停机，不依赖中断把最后的输出送出去
+void panic(const char *s) {
+    intr_off();
+    console_panic();
+    printf("panic: %s\n", s);
+    while (1);
 }
@@ -0,0 +1,105 @@
+// kernel/proc/futex.c
+// futex：按 (地址空间, 用户地址) 哈希的等待队列表
+// 用户态互斥锁只有在发生竞争时才调用 futex 进入内核
+#include "riscv.h"
+#include "proc/proc.h"
+
+#define FUTEX_HASH_BITS 6
+#define NFUTEX_BUCKET   (1 << FUTEX_HASH_BITS)
+
+// 每个桶是一条 FIFO 等待链（通过 proc->futex_next 串起来）
+struct futex_bucket {
+    struct proc *head;
+    struct proc *tail;
+};
+
+static struct futex_bucket futex_table[NFUTEX_BUCKET];
+
+// 同一页表内的地址才是同一个 futex（线程共享页表）
+static inline int futex_match(struct proc *p, pagetable_t pt, uint64_t addr) {
+    return p->futex_addr == addr && p->pagetable == pt;
+}
+
+static struct futex_bucket* futex_hash(pagetable_t pt, uint64_t addr) {
+    uint64_t key = (addr >> 2) ^ ((uint64_t)pt >> PGSHIFT);
+    key *= 0x9E3779B97F4A7C15ULL;  // Fibonacci 哈希
+    return &futex_table[key >> (64 - FUTEX_HASH_BITS)];
+}
+
+// 若 *addr == val 则睡眠，直到 futex_wake
+// 返回 0 表示被唤醒，-1 表示值已改变（调用者应重试）
+int futex_wait(int *addr, int val) {
+    struct proc *p = current_proc;
+    if (p == 0 || addr == 0 || ((uint64_t)addr & 3) != 0) {
+        return -1;
+    }
+
+    // 关中断后再比较，保证检查与入队之间不会丢失唤醒
+    int intr = intr_get();
+    intr_off();
+
+    if (*(volatile int*)addr != val) {
+        if (intr) intr_on();
+        return -1;
+    }
+
+    struct futex_bucket *b = futex_hash(p->pagetable, (uint64_t)addr);
+    p->futex_addr = (uint64_t)addr;
+    p->futex_next = 0;
+    if (b->tail) {
+        b->tail->futex_next = p;
+    } else {
+        b->head = p;
+    }
+    b->tail = p;
+
+    // futex_wake 会把我们从桶中摘下并清零 futex_addr
+    while (p->futex_addr != 0) {
+        sleep(p);
+    }
+
+    if (intr) intr_on();
+    return 0;
+}
+
+// 唤醒最多 nwake 个在 addr 上等待的进程，返回唤醒个数
+int futex_wake(int *addr, int nwake) {
+    struct proc *cur = current_proc;
+    if (addr == 0 || nwake <= 0) {
+        return 0;
+    }
+    pagetable_t pt = cur ? cur->pagetable : 0;
+
+    int intr = intr_get();
+    intr_off();
+
+    struct futex_bucket *b = futex_hash(pt, (uint64_t)addr);
+    struct proc *prev = 0;
+    struct proc *p = b->head;
+    int woken = 0;
+
+    while (p && woken < nwake) {
+        struct proc *next = p->futex_next;
+        if (futex_match(p, pt, (uint64_t)addr)) {
+            // 从等待链摘下
+            if (prev) {
+                prev->futex_next = next;
+            } else {
+                b->head = next;
+            }
+            if (b->tail == p) {
+                b->tail = prev;
+            }
+            p->futex_next = 0;
+            p->futex_addr = 0;
+            wakeup(p);
+            woken++;
+        } else {
+            prev = p;
+        }
+        p = next;
+    }
+
+    if (intr) intr_on();
+    return woken;
+}
@@ -3,12 +3,22 @@
 #include "printf.h"
 #include "trap/trap.h"
 #include "proc/proc.h"
+#include "mm/vm.h"
+#include "string.h"
+#include "uring.h"
+#include "vdso.h"
+#include "file.h"
+#include "klog.h"
+#include "fs.h"
 
 struct proc proc[NPROC];
 struct proc *current_proc = 0;
 
 static int next_pid = 1;
 
+// 调度器自己的上下文（不再借用 proc[0]）
+static struct context sched_context;
+
 // 分配内核栈（1页）
 static uint64_t alloc_kstack() {
     return (uint64_t)alloc_page();
@@ -27,48 +37,227 @@ void proc_init(void) {
     printf("proc_init: process system initialized\n");
 }
 
-// 创建新进程
-int create_process(void (*entry)(void)) {
+// 用户线程：在内核栈顶构造 trapframe，经 userret 进入 U 模式
+static void user_thread_start(struct proc *p) {
+    struct trapframe *tf = (struct trapframe*)(p->kstack + PGSIZE) - 1;
+    memset(tf, 0, sizeof(*tf));
+    tf->epc = (uint64_t)p->thread_fn;
+    tf->sp = p->thread_stack;
+    tf->a0 = (uint64_t)p->thread_arg;
+    p->trapframe = tf;
+
+    intr_off();
+    w_sstatus((r_sstatus() & ~SSTATUS_SPP) | SSTATUS_SPIE);
+    userret(tf);
+}
+
+// 新进程/线程第一次被调度时从这里开始执行
+static void proc_start(void) {
+    struct proc *p = current_proc;
+
+    if (p->pagetable) {
+        user_thread_start(p);
+    }
+
+    // 从 trap 中切换过来时 SIE 为 0，这里重新打开中断
+    intr_on();
+
+    if (p->thread_fn) {
+        p->thread_fn(p->thread_arg);
+    } else {
+        p->entry();
+    }
+    exit_process(0);
+}
+
+// 分配一个空闲的进程槽位并初始化公共字段
+static struct proc* alloc_proc(void) {
     for (int i = 0; i < NPROC; i++) {
         if (proc[i].state == UNUSED) {
             struct proc *p = &proc[i];
-            p->pid = next_pid++;
-            p->entry = entry;
             p->kstack = alloc_kstack();
             if (p->kstack == 0) {
                 printf("create_process: out of memory\n");
-                return -1;
+                return 0;
             }
+            p->pid = next_pid++;
+            p->tgid = p->pid;
+            p->parent = current_proc ? current_proc->pid : 0;
+            p->pagetable = 0;
+            p->trapframe = 0;
+            p->entry = 0;
+            p->thread_fn = 0;
+            p->thread_arg = 0;
+            p->clear_tid = 0;
+            p->thread_stack = 0;
+            p->chan = 0;
+            p->futex_addr = 0;
+            p->futex_next = 0;
+            memset(p->vma, 0, sizeof(p->vma));
+            p->uring = 0;
+            p->nsyscall = 0;
+            memset(p->perf_count, 0, sizeof(p->perf_count));
+            p->fdt = 0;
 
-            // 设置初始上下文：entry 是入口，kstack 是栈
+            // 设置初始上下文：从 proc_start 开始，kstack 是栈
+            for (int j = 0; j < sizeof(p->context) / sizeof(uint64_t); j++) {
+                ((uint64_t*)&p->context)[j] = 0;
+            }
             p->context.sp = p->kstack + PGSIZE;  // 栈顶
-            p->context.ra = (uint64_t)entry;     // 返回地址 = 入口
-
-            p->state = RUNNABLE;
-            printf("create_process: PID %d created\n", p->pid);
-            return p->pid;
+            p->context.ra = (uint64_t)proc_start;
+            return p;
         }
     }
     printf("create_process: process table full\n");
-    return -1;
+    return 0;
+}
+
+// 创建新进程
+int create_process(void (*entry)(void)) {
+    struct proc *p = alloc_proc();
+    if (p == 0) {
+        return -1;
+    }
+    // 子进程继承创建者的 fd 表副本；启动时创建的任务从控制台 0/1/2 开始
+    p->fdt = current_proc && current_proc->fdt ? fdt_copy(current_proc->fdt) : fdt_alloc();
+    if (p->fdt == 0) {
+        free_kstack(p->kstack);
+        return -1;
+    }
+    p->entry = entry;
+    p->state = RUNNABLE;
+    klog(KLOG_DEBUG, "create_process: PID %d created\n", p->pid);
+    return p->pid;
 }
 
-// 退出当前进程
+// 创建与当前进程共享页表的线程（clone）
+// stack 为 0 时使用线程自己的内核栈
+int create_thread(void (*fn)(void *), void *arg, uint64_t stack, int *ctid) {
+    struct proc *cur = current_proc;
+    if (cur == 0 || fn == 0) {
+        return -1;
+    }
+
+    struct proc *p = alloc_proc();
+    if (p == 0) {
+        return -1;
+    }
+    p->tgid = cur->tgid;
+    p->pagetable = cur->pagetable;  // 共享地址空间：每个线程持有页表的一个引用
+    if (p->pagetable) {
+        page_dup(p->pagetable);
+    }
+    memcpy(p->vma, cur->vma, sizeof(p->vma));
+    for (int i = 0; i < NVMA; i++) {
+        if (p->vma[i].ip) {
+            idup(p->vma[i].ip);  // 各线程的 VMA 各自持有文件引用
+        }
+    }
+    p->fdt = cur->fdt;  // 线程共享 fd 表
+    if (p->fdt) {
+        p->fdt->ref++;
+    }
+    p->thread_fn = fn;
+    p->thread_arg = arg;
+    p->clear_tid = ctid;
+    p->thread_stack = stack & ~0xFUL;  // 16 字节对齐
+    if (p->pagetable) {
+        // 用户线程：内核栈顶留给 trapframe，用户栈由 userret 装入
+        p->context.sp = p->kstack + PGSIZE - sizeof(struct trapframe);
+    } else if (stack) {
+        p->context.sp = p->thread_stack;
+    }
+    if (ctid) {
+        *ctid = p->pid;
+    }
+    p->state = RUNNABLE;
+    return p->pid;
+}
+
+// 让出 CPU，切换回调度器
+void sched(void) {
+    int intr = intr_get();
+    intr_off();
+    swtch(&current_proc->context, &sched_context);
+    if (intr) {
+        intr_on();
+    }
+}
+
+// 主动放弃 CPU（时钟中断抢占也走这里）
+void yield(void) {
+    current_proc->state = RUNNABLE;
+    sched();
+}
+
+// 在 chan 上睡眠，直到被 wakeup
+// 调用者负责在检查条件之前关中断，避免丢失唤醒
+void sleep(void *chan) {
+    struct proc *p = current_proc;
+    p->chan = chan;
+    p->state = SLEEPING;
+    sched();
+    p->chan = 0;
+}
+
+// 唤醒所有在 chan 上睡眠的进程
+void wakeup(void *chan) {
+    for (int i = 0; i < NPROC; i++) {
+        if (proc[i].state == SLEEPING && proc[i].chan == chan) {
+            proc[i].state = RUNNABLE;
+        }
+    }
+}
+
+// 退出当前进程（不返回）
 void exit_process(int status) {
-    if (current_proc) {
-        current_proc->exit_status = status;
-        current_proc->state = ZOMBIE;
-        printf("Process %d exited with status %d\n", current_proc->pid, status);
+    struct proc *p = current_proc;
+
+    intr_off();
+    p->exit_status = status;
+    klog(status ? KLOG_INFO : KLOG_DEBUG, "Process %d exited with status %d\n", p->pid, status);
+
+    // 每个任务的硬件事件计数留在日志环里，dmesg 可查
+    uint64_t c[PERF_NEVENTS];
+    if (perf_counts(p, c, PERF_NEVENTS) & (1 << PERF_CYCLES)) {
+        klog(KLOG_DEBUG, "perf: pid %d cycles %lu instret %lu cache_misses %lu\n",
+             p->pid, c[PERF_CYCLES], c[PERF_INSTRET], c[PERF_CACHE_MISSES]);
+    }
+
+    if (p->fdt) {
+        fdt_put(p->fdt);  // 最后一个使用者关闭所有文件
+        p->fdt = 0;
+    }
+
+    // 线程退出：清零 tid 并唤醒 join 者
+    if (p->clear_tid) {
+        *p->clear_tid = 0;
+        futex_wake(p->clear_tid, 1);
     }
-    // 触发调度
-    //scheduler();
+
+    // 放弃地址空间：同组其他线程可能还在用这张页表，最后一个使用者才释放
+    // 先切回内核页表，之后不能再访问用户内存
+    uring_free(p);
+    vma_free(p);
+    if (p->pagetable) {
+        w_satp(MAKE_SATP(kernel_pagetable));
+        sfence_vma();
+        uvmput(p->pagetable);
+        p->pagetable = 0;
+    }
+
+    p->state = ZOMBIE;
+    sched();
+
+    printf("exit_process: zombie %d rescheduled\n", p->pid);
+    while (1);
 }
 
 // 等待子进程（简化：等待任意进程）
 int wait_process(int *status) {
     while (1) {
         for (int i = 0; i < NPROC; i++) {
-            if (proc[i].state == ZOMBIE) {
+            if (proc[i].state == ZOMBIE && proc[i].pid == proc[i].tgid) {
                 int pid = proc[i].pid;
                 if (status) *status = proc[i].exit_status;
                 free_kstack(proc[i].kstack);
@@ -77,27 +266,49 @@ int wait_process(int *status) {
             }
         }
         // 简单轮询（实际应 sleep）
+        if (current_proc) {
+            yield();
+        }
     }
 }
 
 // 调度器（轮转）
 void scheduler(void) {
     while (1) {
-        // 允许中断（时钟中断可能唤醒新进程）
-        // 在实验4中已全局开中断
+        // 空闲时允许时钟中断；切换前关中断
+        intr_on();
+        intr_off();
 
         for (int i = 0; i < NPROC; i++) {
             if (proc[i].state == RUNNABLE) {
                 struct proc *p = &proc[i];
                 p->state = RUNNING;
                 current_proc = p;
+                vdso_set_pid(p->pid);
+
+                // 用户进程使用自己的页表（内核部分共享）
+                if (p->pagetable) {
+                    w_satp(MAKE_SATP(p->pagetable));
+                    sfence_vma();
+                }
 
-                // 切换到进程上下文
-                swtch(&proc[0].context, &p->context);
+                // 切换到进程上下文；硬件事件计数按进程累计
+                perf_switch_in(p);
+                swtch(&sched_context, &p->context);
+                perf_switch_out(p);
 
-                // 返回后，进程已让出
+                // 返回后，进程已让出（RUNNABLE / SLEEPING / ZOMBIE）
                 current_proc = 0;
-                p->state = RUNNABLE;  // 下次可再调度
+                if (p->pagetable) {
+                    w_satp(MAKE_SATP(kernel_pagetable));
+                    sfence_vma();
+                }
+
+                // 线程由调度器回收：它不能在自己的内核栈上释放该栈
+                if (p->state == ZOMBIE && p->pid != p->tgid) {
+                    free_kstack(p->kstack);
+                    p->state = UNUSED;
+                }
             }
         }
     }
@@ -0,0 +1,222 @@
+// kernel/prof.c
+// 时钟中断采样 profiler
+// 内核只在一个 hart 上调度，采样表就是这个 hart 的；采样在 kerneltrap 中（中断已关）进行，不需要锁
+#include "riscv.h"
+#include "printf.h"
+#include "string.h"
+#include "prof.h"
+#include "fdt.h"
+#include "trap/trap.h"
+#include "proc/proc.h"
+
+extern char etext[];
+
+// 一条合并后的调用链：pc[0] 为被打断的 pc，之后依次是各层返回地址
+struct prof_stack {
+    uint32_t count;      // 0 表示空槽
+    int pid;             // 0 表示调度器（空闲）
+    short user;          // 在 U 模式被打断：没有内核调用链
+    short depth;
+    uint64_t pc[PROF_DEPTH];
+};
+
+static struct prof_stack prof_stacks[PROF_NSTACKS];
+static int prof_nstacks;
+static uint64_t prof_samples;
+static uint64_t prof_dropped;
+
+static volatile int prof_on;
+static int prof_hz;
+static uint64_t prof_interval;   // rdtime 计数
+static uint64_t prof_stop_at;    // 非 0：到这个时刻自动停止并唤醒 prof_task
+
+// 沿帧指针回溯（需要 -fno-omit-frame-pointer）：fp 指向本帧的栈顶，
+// fp-8 是返回地址，fp-16 是调用者的 fp。只在被打断时所在的栈页内回溯，
+// fp 越界、未对齐、不递增或返回地址不在内核代码段时停止
+static int prof_backtrace(struct trapframe *tf, uint64_t *pc, int max) {
+    uint64_t lo = tf->sp;
+    uint64_t hi = PGROUNDDOWN(lo) + PGSIZE;
+    uint64_t fp = tf->s0;
+    int n = 0;
+
+    while (n < max && fp > lo && fp <= hi && (fp & 7) == 0) {
+        uint64_t ra = ((uint64_t*)fp)[-1];
+        uint64_t next = ((uint64_t*)fp)[-2];
+        if (ra < KERNBASE || ra >= (uint64_t)etext) break;
+        pc[n++] = ra;
+        lo = fp;
+        fp = next;
+    }
+    return n;
+}
+
+static uint64_t prof_hash(int pid, const uint64_t *pc, int depth) {
+    uint64_t h = 0xcbf29ce484222325ULL ^ (uint64_t)pid;
+    for (int i = 0; i < depth; i++) {
+        h = (h ^ pc[i]) * 0x100000001b3ULL;
+    }
+    return h ^ (h >> 29);
+}
+
+static int pc_equal(const uint64_t *a, const uint64_t *b, int n) {
+    for (int i = 0; i < n; i++) {
+        if (a[i] != b[i]) return 0;
+    }
+    return 1;
+}
+
+// 时钟中断中调用：采样开启时记录一个样本
+void prof_sample(struct trapframe *tf, uint64_t sstatus) {
+    if (!prof_on) return;
+    if (prof_stop_at && r_time() >= prof_stop_at) {
+        prof_on = 0;
+        wakeup(&prof_stop_at);
+        return;
+    }
+    prof_record(tf, sstatus);
+}
+
+// 把被打断处的调用链记入采样表（时钟采样与 perf 的计数器溢出采样共用）
+void prof_record(struct trapframe *tf, uint64_t sstatus) {
+    uint64_t pc[PROF_DEPTH];
+    int user = (sstatus & SSTATUS_SPP) == 0;
+    int pid = current_proc ? current_proc->pid : 0;
+    int depth = 1;
+
+    pc[0] = tf->epc;
+    if (!user) {
+        depth += prof_backtrace(tf, pc + 1, PROF_DEPTH - 1);
+    }
+    prof_samples++;
+
+    // 开放寻址：相同调用链只加计数；新调用链先写内容再写 count，dump 不会看到半条记录
+    uint64_t h = prof_hash(pid, pc, depth);
+    for (int probe = 0; probe < PROF_NSTACKS; probe++) {
+        struct prof_stack *s = &prof_stacks[(h + probe) & (PROF_NSTACKS - 1)];
+        if (s->count == 0) {
+            if (prof_nstacks >= PROF_NSTACKS * 3 / 4) break;  // 保持装填率，探测链不会太长
+            s->pid = pid;
+            s->user = user;
+            s->depth = depth;
+            memcpy(s->pc, pc, depth * sizeof(uint64_t));
+            __atomic_store_n(&s->count, 1, __ATOMIC_RELEASE);
+            prof_nstacks++;
+            return;
+        }
+        if (s->pid == pid && s->user == user && s->depth == depth &&
+            pc_equal(s->pc, pc, depth)) {
+            s->count++;
+            return;
+        }
+    }
+    prof_dropped++;
+}
+
+// 下一次时钟中断的时刻：不采样时就是调度节拍，采样时取两者中较早的
+uint64_t prof_deadline(uint64_t now, uint64_t next_tick) {
+    if (!prof_on) return next_tick;
+    uint64_t t = now + prof_interval;
+    return t < next_tick ? t : next_tick;
+}
+
+static void prof_reset(void) {
+    memset(prof_stacks, 0, sizeof(prof_stacks));
+    prof_nstacks = 0;
+    prof_samples = 0;
+    prof_dropped = 0;
+}
+
+int prof_ctl(int cmd, int arg) {
+    int intr = intr_get();
+    int r = 0;
+
+    // 输出耗时长，不关中断；采样表只会增加计数或新记录
+    if (cmd == PROF_DUMP) {
+        prof_dump();
+        return 0;
+    }
+
+    intr_off();
+    switch (cmd) {
+    case PROF_START:
+        if (prof_on || arg < 0 || arg > PROF_HZ_MAX) {
+            r = -1;
+            break;
+        }
+        prof_hz = arg ? arg : PROF_HZ_DEFAULT;
+        prof_interval = TIMEBASE_FREQ / prof_hz;
+        prof_stop_at = 0;
+        prof_on = 1;
+        sbi_set_timer(r_time() + prof_interval);  // 不必等到下一个调度节拍
+        break;
+    case PROF_STOP:
+        r = prof_on ? (int)prof_samples : -1;
+        prof_on = 0;
+        wakeup(&prof_stop_at);
+        break;
+    case PROF_RESET:
+        if (prof_on) {
+            r = -1;
+        } else {
+            prof_reset();
+        }
+        break;
+    default:
+        r = -1;
+    }
+    if (intr) {
+        intr_on();
+    }
+    return r;
+}
+
+// 输出格式（scripts/prof.py 解析）：
+//   prof: begin hz=<hz> samples=<n> stacks=<n> dropped=<n>
+//   prof: <count> <pid> <k|u> <pc0> <ret1> <ret2> ...    （十六进制，pc0 为被打断的 pc）
+//   prof: end
+void prof_dump(void) {
+    char line[32 + PROF_DEPTH * 20];
+
+    printf("prof: begin hz=%d samples=%lu stacks=%d dropped=%lu\n",
+           prof_hz, prof_samples, prof_nstacks, prof_dropped);
+    for (int i = 0; i < PROF_NSTACKS; i++) {
+        struct prof_stack *s = &prof_stacks[i];
+        uint32_t count = __atomic_load_n(&s->count, __ATOMIC_ACQUIRE);
+        if (count == 0) continue;
+        int n = snprintf(line, sizeof(line), "%u %d %c", count, s->pid, s->user ? 'u' : 'k');
+        for (int j = 0; j < s->depth; j++) {
+            n += snprintf(line + n, sizeof(line) - n, " %lx", s->pc[j]);
+        }
+        printf("prof: %s\n", line);
+    }
+    printf("prof: end\n");
+}
+
+// 启动参数 prof[=hz] 开启采样，prof_secs=<n> 设置多久之后停止（默认 PROF_SECS 秒）
+// 返回 1 表示已开启，调用者应创建 prof_task 在停止后输出结果
+int prof_init(void) {
+    int hz = 0, secs = PROF_SECS;
+
+    if (!machine_bootarg("prof", &hz)) return 0;
+    machine_bootarg("prof_secs", &secs);
+    if (prof_ctl(PROF_START, hz) < 0) {
+        printf("prof: bad sampling rate %d\n", hz);
+        return 0;
+    }
+    if (secs > 0) {
+        prof_stop_at = r_time() + (uint64_t)secs * TIMEBASE_FREQ;
+    }
+    printf("prof: sampling at %d Hz for %d s\n", prof_hz, secs);
+    return 1;
+}
+
+// 等到启动参数开启的采样结束，然后输出
+void prof_task(void) {
+    intr_off();
+    while (prof_on) {
+        sleep(&prof_stop_at);
+    }
+    intr_on();
+    prof_dump();
+    exit(0);
+}
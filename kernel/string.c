@@ -1,31 +1,187 @@
 // kernel/string.c
+// 标量实现按 64 位字处理，主循环展开 4 次；启动时探测到 V 扩展后，
+// 较长的操作改用 string_rvv.S 中的向量实现
 #include "riscv.h"
+#include "string.h"
 
-void* memcpy(void *dst, const void *src, uint64_t n) {
-    char *d = (char*)dst;
-    const char *s = (const char*)src;
+typedef uint64_t __attribute__((may_alias)) word_t;
+
+#define ONES  0x0101010101010101UL
+#define HIGHS 0x8080808080808080UL
+#define HASZERO(w) (((w) - ONES) & ~(w) & HIGHS)   // 字中是否有 0 字节
+
+#define RVV_MIN 64   // 短于该长度时 vsetvli 的固定开销不划算
+
+int string_use_rvv;    // cpu_probe 发现 V 扩展后置 1
+int string_use_cboz;   // cpu_probe 发现 Zicboz 后置 1
+
+// 向量寄存器只有一份且不随进程切换保存：同一时刻只允许一个向量操作，
+// 被抢占或在用户页缺页中嵌套调用时，其他调用者走标量路径
+static int rvv_busy;
+
+static int rvv_get(void) {
+    return string_use_rvv && __atomic_exchange_n(&rvv_busy, 1, __ATOMIC_ACQUIRE) == 0;
+}
+
+static void rvv_put(void) {
+    __atomic_store_n(&rvv_busy, 0, __ATOMIC_RELEASE);
+}
+
+static void* memcpy_word(void *dst, const void *src, uint64_t n) {
+    unsigned char *d = dst;
+    const unsigned char *s = src;
+
+    if (n >= 16) {
+        while ((uint64_t)d & 7) {
+            *d++ = *s++;
+            n--;
+        }
+        word_t *dw = (word_t*)d;
+        uint64_t sh = ((uint64_t)s & 7) * 8;
+        if (sh == 0) {
+            const word_t *sw = (const word_t*)s;
+            for (; n >= 32; n -= 32, dw += 4, sw += 4) {
+                uint64_t a = sw[0], b = sw[1], c = sw[2], e = sw[3];
+                dw[0] = a;
+                dw[1] = b;
+                dw[2] = c;
+                dw[3] = e;
+            }
+            for (; n >= 8; n -= 8) {
+                *dw++ = *sw++;
+            }
+            s = (const unsigned char*)sw;
+        } else {
+            // 源与目的错位：读对齐的源字移位拼接，多读的字节不会越过所需最后一字节所在的字
+            const word_t *sw = (const word_t*)(s - sh / 8);
+            uint64_t w0 = *sw++;
+            for (; n >= 8; n -= 8) {
+                uint64_t w1 = *sw++;
+                *dw++ = (w0 >> sh) | (w1 << (64 - sh));
+                w0 = w1;
+            }
+            s = (const unsigned char*)sw - 8 + sh / 8;
+        }
+        d = (unsigned char*)dw;
+    }
     while (n--) {
         *d++ = *s++;
     }
     return dst;
 }
 
-void* memset(void *dst, int c, uint64_t n) {
-    char *d = (char*)dst;
+static void* memset_word(void *dst, int c, uint64_t n) {
+    unsigned char *d = dst;
+
+    if (n >= 16) {
+        uint64_t w = ONES * (unsigned char)c;
+        while ((uint64_t)d & 7) {
+            *d++ = c;
+            n--;
+        }
+        word_t *dw = (word_t*)d;
+        for (; n >= 32; n -= 32, dw += 4) {
+            dw[0] = w;
+            dw[1] = w;
+            dw[2] = w;
+            dw[3] = w;
+        }
+        for (; n >= 8; n -= 8) {
+            *dw++ = w;
+        }
+        d = (unsigned char*)dw;
+    }
     while (n--) {
         *d++ = c;
     }
     return dst;
 }
 
-int strcmp(const char *s1, const char *s2) {
+// 对齐后按字查找 0 字节；对齐的字读取不会跨页，读到结尾之后的字节是安全的
+static size_t strlen_word(const char *s) {
+    const char *p = s;
+
+    for (; (uint64_t)p & 7; p++) {
+        if (*p == 0) return p - s;
+    }
+    const word_t *w = (const word_t*)p;
+    while (!HASZERO(*w)) {
+        w++;
+    }
+    for (p = (const char*)w; *p; p++)
+        ;
+    return p - s;
+}
+
+// 两个串同余对齐时按字比较，找到不同或含 0 的字后逐字节确定结果
+static int strcmp_word(const char *s1, const char *s2) {
+    if ((((uint64_t)s1 ^ (uint64_t)s2) & 7) == 0) {
+        for (; (uint64_t)s1 & 7; s1++, s2++) {
+            if (*s1 == 0 || *s1 != *s2) goto out;
+        }
+        const word_t *w1 = (const word_t*)s1, *w2 = (const word_t*)s2;
+        while (*w1 == *w2 && !HASZERO(*w1)) {
+            w1++;
+            w2++;
+        }
+        s1 = (const char*)w1;
+        s2 = (const char*)w2;
+    }
     while (*s1 && (*s1 == *s2)) {
         s1++;
         s2++;
     }
+out:
     return *(unsigned char*)s1 - *(unsigned char*)s2;
 }
 
+void* memcpy(void *dst, const void *src, uint64_t n) {
+    if (n >= RVV_MIN && rvv_get()) {
+        memcpy_rvv(dst, src, n);
+        rvv_put();
+        return dst;
+    }
+    return memcpy_word(dst, src, n);
+}
+
+void* memset(void *dst, int c, uint64_t n) {
+    if (n >= RVV_MIN && rvv_get()) {
+        memset_rvv(dst, c, n);
+        rvv_put();
+        return dst;
+    }
+    return memset_word(dst, c, n);
+}
+
+int strcmp(const char *s1, const char *s2) {
+    if (rvv_get()) {
+        int r = strcmp_rvv(s1, s2);
+        rvv_put();
+        return r;
+    }
+    return strcmp_word(s1, s2);
+}
+
+size_t strlen(const char *s) {
+    if (rvv_get()) {
+        size_t n = strlen_rvv(s);
+        rvv_put();
+        return n;
+    }
+    return strlen_word(s);
+}
+
+// 清零一页：支持 Zicboz 时整块清零，不需要先把旧内容读进缓存
+void page_zero(void *pg) {
+    if (string_use_cboz) {
+        for (char *p = pg; p < (char*)pg + PGSIZE; p += CBO_BLOCK) {
+            cbo_zero(p);
+        }
+        return;
+    }
+    memset(pg, 0, PGSIZE);
+}
+
 char* strcpy(char *dst, const char *src) {
     char *ret = dst;
     while ((*dst++ = *src++) != '\0')
@@ -33,13 +189,6 @@ char* strcpy(char *dst, const char *src) {
     return ret;
 }
 
-size_t strlen(const char *s) {
-    const char *p = s;
-    while (*p)
-        p++;
-    return p - s;
-}
-
 char* strchr(const char *s, int c) {
     while (*s) {
         if (*s == (char)c)
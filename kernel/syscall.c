@@ -2,83 +2,18 @@
 #include "syscall.h"
 #include "proc/proc.h"
 #include "printf.h"
-#include "uart.h"
+#include "console.h"
 #include "string.h"
-
-// ============ RAMFS 模拟 ============
-#define MAX_FILES 8
-#define MAX_FILE_SIZE 4096
-#define MAX_FILENAME 28
-
-enum {
-    FT_NONE = 0,
-    FT_REG = 1,
-};
-
-struct file_data {
-    char name[MAX_FILENAME];
-    int type;
-    int size;
-    char data[MAX_FILE_SIZE];
-};
-
-struct open_file {
-    int used;
-    int fd;              // 文件描述符编号
-    struct file_data *fp; // 指向文件数据
-    int offset;          // 当前读写位置
-};
-
-static struct file_data files[MAX_FILES];
-static struct open_file ofiles[MAX_FILES];
-static int next_fd = 0;
-static int initialized = 0;
-
-static void fs_init_once(void) {
-    if (initialized) return;
-    for (int i = 0; i < MAX_FILES; i++) {
-        files[i].type = FT_NONE;
-    }
-    for (int i = 0; i < MAX_FILES; i++) {
-        ofiles[i].used = 0;
-    }
-    initialized = 1;
-}
-
-// 查找已存在的文件（按 name）
-static struct file_data* find_file(const char *name) {
-    for (int i = 0; i < MAX_FILES; i++) {
-        if (files[i].type == FT_REG && strcmp(files[i].name, name) == 0) {
-            return &files[i];
-        }
-    }
-    return 0;
-}
-
-// 分配新文件
-static struct file_data* alloc_file(const char *name) {
-    for (int i = 0; i < MAX_FILES; i++) {
-        if (files[i].type == FT_NONE) {
-            strcpy(files[i].name, name);
-            files[i].type = FT_REG;
-            files[i].size = 0;
-            return &files[i];
-        }
-    }
-    return 0;
-}
-
-// 分配文件描述符
-static struct open_file* alloc_fd(void) {
-    for (int i = 0; i < MAX_FILES; i++) {
-        if (!ofiles[i].used) {
-            ofiles[i].used = 1;
-            ofiles[i].fd = next_fd++;
-            return &ofiles[i];
-        }
-    }
-    return 0;
-}
+#include "uring.h"
+#include "fs.h"
+#include "file.h"
+#include "blk/blk.h"
+#include "journal.h"
+#include "pipe.h"
+#include "mm/vm.h"
+#include "klog.h"
+#include "prof.h"
+#include "perf.h"
 
 // ============ 系统调用实现 ============
 
@@ -92,6 +27,26 @@ int sys_open(void);
 int sys_close(void);
 int sys_read(void);
 int sys_unlink(void);
+int sys_clone(void);
+int sys_futex(void);
+int sys_exec(void);
+int sys_ring_setup(void);
+int sys_ring_enter(void);
+int sys_readv(void);
+int sys_writev(void);
+int sys_pread(void);
+int sys_pwrite(void);
+int sys_mkdir(void);
+int sys_rmdir(void);
+int sys_dup(void);
+int sys_sync(void);
+int sys_pipe(void);
+int sys_sendfile(void);
+int sys_dmesg(void);
+int sys_loglevel(void);
+int sys_prof(void);
+int sys_perf_read(void);
+int sys_perf_sample(void);
 
 // 系统调用分发表
 static int (*syscalls[])(void) = {
@@ -104,9 +59,29 @@ static int (*syscalls[])(void) = {
     [SYS_close]  = sys_close,
     [SYS_read]   = sys_read,
     [SYS_unlink] = sys_unlink,
+    [SYS_clone]  = sys_clone,
+    [SYS_futex]  = sys_futex,
+    [SYS_exec]   = sys_exec,
+    [SYS_ring_setup] = sys_ring_setup,
+    [SYS_ring_enter] = sys_ring_enter,
+    [SYS_readv]  = sys_readv,
+    [SYS_writev] = sys_writev,
+    [SYS_pread]  = sys_pread,
+    [SYS_pwrite] = sys_pwrite,
+    [SYS_mkdir]  = sys_mkdir,
+    [SYS_rmdir]  = sys_rmdir,
+    [SYS_dup]    = sys_dup,
+    [SYS_sync]   = sys_sync,
+    [SYS_pipe]   = sys_pipe,
+    [SYS_sendfile] = sys_sendfile,
+    [SYS_dmesg]  = sys_dmesg,
+    [SYS_loglevel] = sys_loglevel,
+    [SYS_prof]   = sys_prof,
+    [SYS_perf_read] = sys_perf_read,
+    [SYS_perf_sample] = sys_perf_sample,
 };
 
-// 参数提取：从 trapframe 获取 a0-a6
+// 参数提取：从 trapframe 获取 a0-a5
 static int argint(int n, int *ip) {
     struct proc *p = current_proc;
     if (!p) return -1;
@@ -114,11 +89,29 @@ static int argint(int n, int *ip) {
         case 0: *ip = p->trapframe->a0; break;
         case 1: *ip = p->trapframe->a1; break;
         case 2: *ip = p->trapframe->a2; break;
+        case 3: *ip = p->trapframe->a3; break;
+        case 4: *ip = p->trapframe->a4; break;
+        case 5: *ip = p->trapframe->a5; break;
         default: return -1;
     }
     return 0;
 }
 
+// 用户进程传入的缓冲区 [base, base+len) 必须整个落在用户地址空间内，
+// 否则内核会替它读写内核内存；内核任务（没有用户页表）传的本来就是内核地址
+int user_range_ok(uint64_t base, uint64_t len) {
+    if (current_proc == 0 || current_proc->pagetable == 0) return 1;
+    return base >= USERBASE && base < USERTOP && len <= USERTOP - base;
+}
+
+// 文件读写会在持有缓存块或处于日志事务中时复制用户缓冲区，这时缺页结束进程会让缓存块
+// 和事务永远不被释放：除了检查范围，还要先把缓冲区的页调入（write：内核要写入缓冲区）
+static int user_buf_ok(uint64_t base, uint64_t len, int write) {
+    if (!user_range_ok(base, len)) return 0;
+    if (current_proc == 0 || current_proc->pagetable == 0) return 1;
+    return vma_prefault(current_proc, base, len, write) == 0;
+}
+
 static uint64_t argaddr(int n) {
     struct proc *p = current_proc;
     if (!p) return 0;
@@ -126,6 +119,9 @@ static uint64_t argaddr(int n) {
         case 0: return p->trapframe->a0;
         case 1: return p->trapframe->a1;
         case 2: return p->trapframe->a2;
+        case 3: return p->trapframe->a3;
+        case 4: return p->trapframe->a4;
+        case 5: return p->trapframe->a5;
         default: return 0;
     }
 }
@@ -135,7 +131,9 @@ static int argstr(int n, char *buf, int max) {
     if (addr == 0 || max <= 0) return -1;
     char *s = (char*)addr;
     int i = 0;
-    while (i < max - 1 && s[i] != '\0') {
+    while (i < max - 1) {
+        if (!user_range_ok(addr + i, 1)) return -1;  // 读出了用户地址空间
+        if (s[i] == '\0') break;
         buf[i] = s[i];
         i++;
     }
@@ -149,6 +147,7 @@ void syscall_dispatch(void) {
     if (!p) return;
 
     int num = p->trapframe->a7;  // 系统调用号在 a7
+    p->nsyscall++;
     if (num > 0 && num < sizeof(syscalls)/sizeof(syscalls[0]) && syscalls[num]) {
         int ret = syscalls[num]();
         p->trapframe->a0 = ret;  // 返回值放 a0
@@ -176,56 +175,283 @@ int sys_fork(void) {
     return -1; // 未实现
 }
 
+// clone(fn, stack, arg, ctid)：创建共享页表的线程，返回 tid
+int sys_clone(void) {
+    uint64_t fn = argaddr(0);
+    uint64_t stack = argaddr(1);
+    uint64_t arg = argaddr(2);
+    uint64_t ctid = argaddr(3);
+    // 创建时写入 tid、退出时清零：必须是用户地址
+    if (ctid && !user_range_ok(ctid, sizeof(int))) return -1;
+    return create_thread((void (*)(void *))fn, (void*)arg, stack, (int*)ctid);
+}
+
+// futex(addr, op, val)
+int sys_futex(void) {
+    uint64_t addr = argaddr(0);
+    int op, val;
+    argint(1, &op);
+    argint(2, &val);
+    if (!user_range_ok(addr, sizeof(int))) return -1;
+
+    switch (op) {
+    case FUTEX_WAIT:
+        return futex_wait((int*)addr, val);
+    case FUTEX_WAKE:
+        return futex_wake((int*)addr, val);
+    default:
+        return -1;
+    }
+}
+
 int sys_wait(void) {
     int *status;
     if (argint(0, (int*)&status) < 0) return -1;
     return wait_process(status);
 }
 
+// ========== 文件操作（系统调用与提交环共用）==========
+
+int file_open(const char *path, int flags) {
+    struct inode *ip;
+    if (flags & 1) { // O_CREATE
+        begin_op();
+        ip = fs_create(path, FT_REG);
+        end_op();
+        if (!ip) return -1; // 已存在或父目录不存在
+    } else {
+        ip = namei(path);
+        if (!ip || ip->type != FT_REG) return -1; // 文件不存在
+    }
+
+    struct file *f = filealloc();
+    if (!f) return -1;
+    f->type = FD_INODE;
+    f->ip = idup(ip);
+
+    int fd = fd_install(current_proc->fdt, f);
+    if (fd < 0) {
+        fileclose(f);
+    }
+    return fd;
+}
+
+int file_close(int fd) {
+    struct file *f = fd_remove(current_proc->fdt, fd);
+    if (!f) return -1;  // fd 未打开
+    fileclose(f);
+    return 0;
+}
+
+// dup(fd)：新 fd 与 fd 共享同一个打开文件对象（包括偏移）
+int file_dup(int fd) {
+    struct file *f = fd_lookup(fd);
+    if (!f) return -1;
+
+    int nfd = fd_install(current_proc->fdt, filedup(f));
+    if (nfd < 0) {
+        fileclose(f);
+    }
+    return nfd;
+}
+
+// 按 WRITE_CHUNK 分成多个事务写入；initramfs 文件先复制到磁盘块
+static int writei_op(struct inode *ip, const char *src, int off, int len) {
+    int tot = 0;
+    if (icopyup(ip) < 0) return -1;
+    while (tot < len) {
+        int m = len - tot < WRITE_CHUNK ? len - tot : WRITE_CHUNK;
+        begin_op();
+        int n = writei(ip, src + tot, off + tot, m);
+        end_op();
+        if (n <= 0) break;
+        tot += n;
+        if (n < m) break;
+    }
+    return tot;
+}
+
+// 在 off 处对一组缓冲区做一次读/写，直接在 inode 数据页与用户缓冲区之间复制
+// 返回传输的总字节数
+static int file_rw_iov(struct inode *ip, const struct iovec *iov, int iovcnt,
+                       int off, int write) {
+    int total = 0;
+
+    for (int i = 0; i < iovcnt; i++) {
+        if (iov[i].len <= 0) continue;
+
+        int n = write ? writei_op(ip, iov[i].base, off, iov[i].len)
+                      : readi(ip, iov[i].base, off, iov[i].len);
+        if (n <= 0) break;  // EOF 或内存不足
+        off += n;
+        total += n;
+        if (n < iov[i].len) break;
+    }
+    return total;
+}
+
+// 管道没有偏移：写要写完每一段，读在某段读不满或管道已空时返回
+static int pipe_rw_iov(struct file *f, const struct iovec *iov, int iovcnt, int write) {
+    if (write ? !f->writable : !f->readable) return -1;
+
+    int total = 0;
+    for (int i = 0; i < iovcnt; i++) {
+        if (iov[i].len <= 0) continue;
+        if (!write && total > 0 && f->pipe->head == f->pipe->tail) break;
+
+        int n = write ? pipe_write(f->pipe, iov[i].base, iov[i].len)
+                      : pipe_read(f->pipe, iov[i].base, iov[i].len);
+        if (n < 0) return total ? total : -1;
+        total += n;
+        if (n < iov[i].len) break;
+    }
+    return total;
+}
+
+// 控制台：每个 iov 整段追加到输出环，由 drainer 送往串口
+static int console_writev(const struct iovec *iov, int iovcnt) {
+    int total = 0;
+    for (int i = 0; i < iovcnt; i++) {
+        console_write(iov[i].base, iov[i].len);
+        total += iov[i].len;
+    }
+    return total;
+}
+
+// iov 数组本身在内核中，各段缓冲区是调用者（用户进程）的地址；write：读操作写入缓冲区
+static int iov_check(const struct iovec *iov, int iovcnt, int write) {
+    if (iov == 0 || iovcnt < 0 || iovcnt > IOV_MAX) return -1;
+    for (int i = 0; i < iovcnt; i++) {
+        if (iov[i].base == 0 || iov[i].len < 0 ||
+            !user_buf_ok((uint64_t)iov[i].base, iov[i].len, write)) return -1;
+    }
+    return 0;
+}
+
+// off < 0 表示使用并推进文件的当前偏移，否则为定位读写（pread/pwrite）
+int file_readv(int fd, const struct iovec *iov, int iovcnt, int off) {
+    if (iov_check(iov, iovcnt, 1) < 0) return -1;
+
+    struct file *f = fd_lookup(fd);
+    if (!f) return -1;
+    if (f->type == FD_CONSOLE) return 0;  // 没有控制台输入
+    if (f->type == FD_PIPE) {
+        return off < 0 ? pipe_rw_iov(f, iov, iovcnt, 0) : -1;
+    }
+
+    int pos = off < 0 ? f->off : off;
+    int len = 0;
+    for (int i = 0; i < iovcnt; i++) {
+        len += iov[i].len;
+    }
+    file_readahead(f, pos, len);
+    int n = file_rw_iov(f->ip, iov, iovcnt, pos, 0);
+    if (off < 0) {
+        f->off += n;
+    }
+    return n;
+}
+
+// 写路径本体：sendfile 直接交来内核中的缓存页，不做用户地址检查
+static int do_writev(int fd, const struct iovec *iov, int iovcnt, int off) {
+    struct file *f = fd_lookup(fd);
+    if (!f) return -1;
+    if (f->type == FD_CONSOLE) {
+        return console_writev(iov, iovcnt);
+    }
+    if (f->type == FD_PIPE) {
+        return off < 0 ? pipe_rw_iov(f, iov, iovcnt, 1) : -1;
+    }
+
+    int pos = off < 0 ? f->off : off;
+    int n = file_rw_iov(f->ip, iov, iovcnt, pos, 1);
+    if (off < 0) {
+        f->off += n;
+    }
+    return n;
+}
+
+int file_writev(int fd, const struct iovec *iov, int iovcnt, int off) {
+    if (iov_check(iov, iovcnt, 0) < 0) return -1;
+    return do_writev(fd, iov, iovcnt, off);
+}
+
+int file_read(int fd, void *buf, int count) {
+    struct iovec iov = { buf, count };
+    return file_readv(fd, &iov, 1, -1);
+}
+
+int file_write(int fd, const void *buf, int count) {
+    struct iovec iov = { (void*)buf, count };
+    return file_writev(fd, &iov, 1, -1);
+}
+
+// sendfile：把 in_fd 的文件页直接交给 out_fd 的写路径（控制台、管道或文件），
+// 数据不经过用户缓冲区，每页只有一次复制；off < 0 时使用并推进 in_fd 的偏移
+// 返回发送的字节数
+int file_sendfile(int out_fd, int in_fd, int off, int len) {
+    static const char zeros[BSIZE];  // 空洞
+
+    struct file *in = fd_lookup(in_fd);
+    struct file *out = fd_lookup(out_fd);
+    if (!in || !out || in->type != FD_INODE || len < 0) return -1;
+    if (out->type == FD_INODE && out->ip == in->ip) return -1;  // 会在同一缓存块上等待自己
+
+    uint pos = off < 0 ? in->off : off;
+    if (pos >= in->ip->size) return 0;
+    if (len > in->ip->size - pos) {
+        len = in->ip->size - pos;
+    }
+    file_readahead(in, pos, len);
+
+    int total = 0;
+    while (total < len) {
+        uint cur = pos + total;
+        int m = BSIZE - cur % BSIZE;
+        if (m > len - total) m = len - total;
+
+        // 持有缓存块期间写出，写到管道时可能阻塞；initramfs 文件直接从镜像发送
+        struct inode *ip = in->ip;
+        struct buf *b = ip->xip ? 0 : ibread(ip, cur / BSIZE);
+        const char *src = ip->xip ? ip->xip + cur : b ? b->data + cur % BSIZE : zeros;
+        struct iovec iov = { (void*)src, m };
+        int n = do_writev(out_fd, &iov, 1, -1);
+        if (b) {
+            brelse(b);
+        }
+        if (n <= 0) break;
+        total += n;
+        if (n < m) break;
+    }
+    if (off < 0) {
+        in->off += total;
+    }
+    return total;
+}
+
+int file_unlink(const char *path) {
+    begin_op();
+    int r = fs_unlink(path);
+    end_op();
+    return r;
+}
+
+// ========== 文件系统调用 ==========
 int sys_write(void) {
     int fd, count;
     uint64_t buf;
     argint(0, &fd);
     buf = argaddr(1);
     argint(2, &count);
-
-    if (fd != 1) return -1;  // 只支持 stdout (fd=1)
-    if (buf == 0 || count < 0) return -1;
-
-    char *s = (char*)buf;
-    for (int i = 0; i < count; i++) {
-        uart_putc(s[i]);
-    }
-    return count;
+    return file_write(fd, (void*)buf, count);
 }
 
-// ========== 新增实现 ==========
 int sys_open(void) {
-    fs_init_once();
     char path[64];
     int flags;
     if (argstr(0, path, sizeof(path)) < 0) return -1;
     argint(1, &flags);
-
-    // 只支持根目录文件：/filename
-    if (path[0] != '/') return -1;
-    const char *name = path + 1;
-    if (strchr(name, '/')) return -1; // 不支持子目录
-
-    struct file_data *fp = find_file(name);
-    if (flags & 1) { // O_CREATE
-        if (fp) return -1; // 已存在
-        fp = alloc_file(name);
-        if (!fp) return -1;
-    } else {
-        if (!fp) return -1; // 文件不存在
-    }
-
-    struct open_file *of = alloc_fd();
-    if (!of) return -1;
-    of->fp = fp;
-    of->offset = 0;
-    return of->fd;
+    return file_open(path, flags);
 }
 
 int sys_close(void) {
@@ -233,16 +459,7 @@ int sys_close(void) {
     if (argint(0, &fd) < 0) {  // ✅ 从 a0 提取 fd
         return -1;
     }
-    if (fd < 0 || fd >= MAX_FILES) {
-        return -1;
-    }
-    for (int i = 0; i < MAX_FILES; i++) {
-        if (ofiles[i].used && ofiles[i].fd == fd) {
-            ofiles[i].used = 0;
-            return 0;
-        }
-    }
-    return -1;  // fd 未打开
+    return file_close(fd);
 }
 
 int sys_read(void) {
@@ -251,43 +468,205 @@ int sys_read(void) {
     argint(0, &fd);
     buf = argaddr(1);
     argint(2, &count);
+    return file_read(fd, (void*)buf, count);
+}
 
-    if (buf == 0 || count < 0) return -1;
-    if (fd < 0 || fd >= MAX_FILES) return -1;
+// 把用户的 iovec 数组复制到内核，避免执行过程中被修改
+static int argiov(int n, int iovcnt, struct iovec *kiov) {
+    struct iovec *uiov = (struct iovec*)argaddr(n);
+    if (uiov == 0 || iovcnt < 0 || iovcnt > IOV_MAX ||
+        !user_range_ok((uint64_t)uiov, iovcnt * sizeof(struct iovec))) return -1;
+    memcpy(kiov, uiov, iovcnt * sizeof(struct iovec));
+    return 0;
+}
 
-    struct open_file *of = 0;
-    for (int i = 0; i < MAX_FILES; i++) {
-        if (ofiles[i].used && ofiles[i].fd == fd) {
-            of = &ofiles[i];
-            break;
-        }
+// readv(fd, iov, iovcnt)
+int sys_readv(void) {
+    int fd, iovcnt;
+    struct iovec iov[IOV_MAX];
+    argint(0, &fd);
+    argint(2, &iovcnt);
+    if (argiov(1, iovcnt, iov) < 0) return -1;
+    return file_readv(fd, iov, iovcnt, -1);
+}
+
+// writev(fd, iov, iovcnt)
+int sys_writev(void) {
+    int fd, iovcnt;
+    struct iovec iov[IOV_MAX];
+    argint(0, &fd);
+    argint(2, &iovcnt);
+    if (argiov(1, iovcnt, iov) < 0) return -1;
+    return file_writev(fd, iov, iovcnt, -1);
+}
+
+// pread(fd, buf, count, off)：不修改文件偏移
+int sys_pread(void) {
+    int fd, count, off;
+    argint(0, &fd);
+    argint(2, &count);
+    argint(3, &off);
+    if (off < 0) return -1;
+    struct iovec iov = { (void*)argaddr(1), count };
+    return file_readv(fd, &iov, 1, off);
+}
+
+// pwrite(fd, buf, count, off)：不修改文件偏移
+int sys_pwrite(void) {
+    int fd, count, off;
+    argint(0, &fd);
+    argint(2, &count);
+    argint(3, &off);
+    if (off < 0) return -1;
+    struct iovec iov = { (void*)argaddr(1), count };
+    return file_writev(fd, &iov, 1, off);
+}
+
+int sys_unlink(void) {
+    char path[64];
+    if (argstr(0, path, sizeof(path)) < 0) return -1;
+    return file_unlink(path);
+}
+
+int sys_dup(void) {
+    int fd;
+    argint(0, &fd);
+    return file_dup(fd);
+}
+
+// 提交日志并把页缓存中的脏块写回磁盘
+int sys_sync(void) {
+    journal_sync();
+    return 0;
+}
+
+// sendfile(out_fd, in_fd, off, len)
+int sys_sendfile(void) {
+    int out_fd, in_fd, off, len;
+    if (argint(0, &out_fd) < 0 || argint(1, &in_fd) < 0 ||
+        argint(2, &off) < 0 || argint(3, &len) < 0) return -1;
+    return file_sendfile(out_fd, in_fd, off, len);
+}
+
+// dmesg(buf, len)：把内核日志环格式化到 buf，返回字节数
+int sys_dmesg(void) {
+    int len;
+    uint64_t buf = argaddr(0);
+    argint(1, &len);
+    if (len > 0 && !user_range_ok(buf, len)) return -1;
+    return klog_read((char*)buf, len);
+}
+
+// loglevel(level)：设置控制台输出的最低级别，返回原级别；level < 0 时只查询
+int sys_loglevel(void) {
+    int level;
+    argint(0, &level);
+    return klog_set_level(level);
+}
+
+// prof(cmd, arg)：控制采样 profiler，命令见 include/prof.h
+int sys_prof(void) {
+    int cmd, arg;
+    if (argint(0, &cmd) < 0 || argint(1, &arg) < 0) return -1;
+    return prof_ctl(cmd, arg);
+}
+
+// perf_read(pid, counts, n)：读出进程 pid（0 为自己）的前 n 个硬件事件计数，
+// 下标见 include/perf.h；返回可用事件的位图，不可用的读出为 0
+int sys_perf_read(void) {
+    int pid, n;
+    uint64_t *counts = (uint64_t*)argaddr(1);
+    if (argint(0, &pid) < 0 || argint(2, &n) < 0 || counts == 0 || n < 0) return -1;
+    if (n > PERF_NEVENTS) n = PERF_NEVENTS;
+    if (!user_range_ok((uint64_t)counts, n * sizeof(uint64_t))) return -1;
+
+    struct proc *p = pid == 0 ? current_proc : 0;
+    for (int i = 0; i < NPROC && p == 0; i++) {
+        if (proc[i].state != UNUSED && proc[i].pid == pid) p = &proc[i];
     }
-    if (!of) return -1;
+    if (p == 0) return -1;
+    return perf_counts(p, counts, n);
+}
+
+// perf_sample(event, period)：每 period 个事件记一个 profiler 样本，
+// period 为 0 时停止并返回记下的样本数
+int sys_perf_sample(void) {
+    int event, period;
+    if (argint(0, &event) < 0 || argint(1, &period) < 0 || period < 0) return -1;
+    return perf_set_sampling(event, period);
+}
 
-    if (of->offset >= of->fp->size) return 0; // EOF
+// pipe(fds)：fds[0] 为读端，fds[1] 为写端
+int sys_pipe(void) {
+    int *fds = (int*)argaddr(0);
+    struct file *rf, *wf;
 
-    int n = count;
-    if (of->offset + n > of->fp->size) {
-        n = of->fp->size - of->offset;
+    if (fds == 0 || !user_range_ok((uint64_t)fds, 2 * sizeof(int))) return -1;
+    if (pipealloc(&rf, &wf) < 0) return -1;
+
+    int rfd = fd_install(current_proc->fdt, rf);
+    int wfd = rfd < 0 ? -1 : fd_install(current_proc->fdt, wf);
+    if (wfd < 0) {
+        if (rfd >= 0) fd_remove(current_proc->fdt, rfd);
+        fileclose(rf);
+        fileclose(wf);
+        return -1;
     }
-    memcpy((void*)buf, of->fp->data + of->offset, n);
-    of->offset += n;
-    return n;
+    fds[0] = rfd;
+    fds[1] = wfd;
+    return 0;
 }
 
-int sys_unlink(void) {
-    fs_init_once();
+int sys_mkdir(void) {
     char path[64];
     if (argstr(0, path, sizeof(path)) < 0) return -1;
+    begin_op();
+    struct inode *ip = fs_create(path, FT_DIR);
+    end_op();
+    return ip ? 0 : -1;
+}
 
-    if (path[0] != '/') return -1;
-    const char *name = path + 1;
-    if (strchr(name, '/')) return -1;
+int sys_rmdir(void) {
+    char path[64];
+    if (argstr(0, path, sizeof(path)) < 0) return -1;
+    begin_op();
+    int r = fs_rmdir(path);
+    end_op();
+    return r;
+}
+
+// exec(path, argv)：成功时不返回到调用者（trapframe 已指向新程序入口）
+int sys_exec(void) {
+    char path[64];
+    if (argstr(0, path, sizeof(path)) < 0) return -1;
+    char **argv = (char**)argaddr(1);
+    // argv 数组与其中的字符串由 push_args 直接读取，先确认都在用户地址空间内
+    for (int i = 0; argv; i++) {
+        if (!user_range_ok((uint64_t)&argv[i], sizeof(char*))) return -1;
+        if (argv[i] == 0) break;
+        for (uint64_t a = (uint64_t)argv[i]; ; a++) {
+            if (!user_range_ok(a, 1)) return -1;
+            if (*(char*)a == '\0') break;
+        }
+    }
+    return exec_load(path, argv);
+}
 
-    struct file_data *fp = find_file(name);
-    if (!fp) return -1;
+// ring_setup(&ring)：把提交/完成环的地址写入 *ring
+int sys_ring_setup(void) {
+    struct proc *p = current_proc;
+    struct uring **ringp = (struct uring**)argaddr(0);
+    if (ringp == 0 || !user_range_ok((uint64_t)ringp, sizeof(*ringp))) return -1;
 
-    // 标记为未使用
-    fp->type = FT_NONE;
+    struct uring *r = uring_setup(p);
+    if (r == 0) return -1;
+    *ringp = p->pagetable ? (struct uring*)URING_VA : r;
     return 0;
 }
+
+// ring_enter(to_submit)：批量执行已提交的操作，返回处理的个数
+int sys_ring_enter(void) {
+    int to_submit;
+    argint(0, &to_submit);
+    return uring_enter(current_proc, to_submit);
+}
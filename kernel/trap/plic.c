@@ -0,0 +1,24 @@
+// kernel/trap/plic.c
+// PLIC：把外部设备中断（virtio 等）路由到 hart 0 的 S 模式
+#include "trap/plic.h"
+#include "printf.h"
+
+void plic_init(void) {
+    // 阈值 0：所有优先级 > 0 的中断都会送达
+    *(volatile uint32_t*)PLIC_STHRESHOLD = 0;
+    printf("plic_init: PLIC ready\n");
+}
+
+void plic_enable(int irq) {
+    *(volatile uint32_t*)PLIC_PRIORITY(irq) = 1;
+    *(volatile uint32_t*)PLIC_SENABLE |= 1U << irq;
+}
+
+// 取得待处理的中断号，没有时返回 0
+int plic_claim(void) {
+    return *(volatile uint32_t*)PLIC_SCLAIM;
+}
+
+void plic_complete(int irq) {
+    *(volatile uint32_t*)PLIC_SCLAIM = irq;
+}
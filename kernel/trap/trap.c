@@ -4,11 +4,23 @@
 #include "trap/trap.h"
 #include "proc/proc.h"
 #include "syscall.h"
+#include "mm/vm.h"
+#include "vdso.h"
+#include "trap/plic.h"
+#include "blk/blk.h"
+#include "journal.h"
+#include "uart.h"
+#include "cpu.h"
+#include "prof.h"
+#include "perf.h"
 
 
 // 全局变量：记录时钟中断次数
 volatile int timer_ticks = 0;
 
+// 下一个调度节拍（间隔 TICK_INTERVAL）；profiler 开启时时钟中断更频繁，但只有到了节拍才算一个 tick
+static uint64_t next_tick;
+
 // SBI 调用：设置下次时钟中断
 void sbi_set_timer(uint64_t stime_value) {
     register uint64_t a0 asm("a0") = stime_value;
@@ -19,6 +31,23 @@ void sbi_set_timer(uint64_t stime_value) {
                   : "memory");
 }
 
+struct sbiret sbi_call(uint64_t ext, uint64_t fid, uint64_t a0, uint64_t a1,
+                       uint64_t a2, uint64_t a3, uint64_t a4) {
+    register uint64_t r0 asm("a0") = a0;
+    register uint64_t r1 asm("a1") = a1;
+    register uint64_t r2 asm("a2") = a2;
+    register uint64_t r3 asm("a3") = a3;
+    register uint64_t r4 asm("a4") = a4;
+    register uint64_t r6 asm("a6") = fid;
+    register uint64_t r7 asm("a7") = ext;
+    asm volatile ("ecall"
+                  : "+r"(r0), "+r"(r1)
+                  : "r"(r2), "r"(r3), "r"(r4), "r"(r6), "r"(r7)
+                  : "memory");
+    struct sbiret ret = { (long)r0, (long)r1 };
+    return ret;
+}
+
 // 获取当前时间（简化）
 uint64_t get_time(void) {
     // RISC-V 没有直接读取时间的 CSR，依赖 SBI 或 mtime
@@ -27,55 +56,125 @@ uint64_t get_time(void) {
 }
 
 // 内核态中断处理函数
-void kerneltrap(void) {
+// tf 指向 kernelvec 在栈上保存的寄存器
+void kerneltrap(struct trapframe *tf) {
     uint64_t scause = r_scause();
     uint64_t sepc = r_sepc();
+    // yield 可能切换到别的进程并改写 sstatus，返回前恢复
+    uint64_t sstatus = r_sstatus();
+    int user = (sstatus & SSTATUS_SPP) == 0 && current_proc;  // 来自 U 模式
 
-    if (scause == 5) {
-        // 时钟中断
-        timer_ticks++;
-        sbi_set_timer(r_time() + 1000000);
-        if (timer_ticks % 10 == 0) {
-            if (current_proc) {
-                swtch(&current_proc->context, &proc[0].context);
+    if (scause == (SCAUSE_INTR | 5)) {
+        // 时钟中断：先采样，再看是否到了调度节拍
+        uint64_t now = r_time();
+        int tick = now >= next_tick;
+        prof_sample(tf, sstatus);
+        if (tick) {
+            next_tick = now + TICK_INTERVAL;
+            timer_ticks++;
+            vdso_tick();
+            journal_tick();
+            pcache_tick();
+        }
+        sbi_set_timer(prof_deadline(now, next_tick));
+        if (tick && timer_ticks % 10 == 0) {
+            if (current_proc && current_proc->state == RUNNING) {
+                yield();
             }
         }
+    } else if (scause == (SCAUSE_INTR | 9)) {
+        // 外部中断：经 PLIC 分发到设备驱动
+        int irq = plic_claim();
+        if (irq == virtio_blk_irq && irq != 0) {
+            virtio_blk_intr();
+        } else if (irq == machine.uart_irq) {
+            uart_intr();
+        } else if (irq) {
+            printf("kerneltrap: unexpected irq %d\n", irq);
+        }
+        if (irq) {
+            plic_complete(irq);
+        }
+    } else if (scause == (SCAUSE_INTR | 13)) {
+        // 计数器溢出（Sscofpmf）：perf_sample 的采样点
+        perf_overflow(tf, sstatus);
     } else if (scause == 8) {
         // 👉 系统调用
         if (current_proc) {
-            // 保存 sepc 到 trapframe
-            current_proc->trapframe->epc = sepc;
+            current_proc->trapframe = tf;
+
+            // 返回时跳过 ecall 指令
+            tf->epc = sepc + 4;
+
+            // 系统调用期间允许时钟中断（futex 等待需要被调度出去）
+            intr_on();
 
             // 👉 调用系统调用分发器
             syscall_dispatch();
 
-            // 更新 sepc：跳过 ecall 指令
-            w_sepc(sepc + 4);
+            intr_off();
+
+            // 用户进程（包括刚 exec 的内核任务）返回 U 模式
+            if (current_proc->pagetable) {
+                sstatus = (sstatus & ~SSTATUS_SPP) | SSTATUS_SPIE;
+            }
         }
+    } else if (scause == 12 || scause == 13 || scause == 15) {
+        // 缺页：用户地址按需加载
+        uint64_t va = r_stval();
+        int kind = scause == 12 ? FAULT_EXEC : scause == 13 ? FAULT_READ : FAULT_WRITE;
+        int uva = current_proc && current_proc->pagetable && va >= USERBASE && va < USERTOP;
+        if (!uva && !user) {
+            printf("Kernel page fault: scause=0x%lx va=0x%lx sepc=0x%lx\n", scause, va, sepc);
+            panic("kerneltrap");
+        }
+        // U 模式访问了用户地址空间之外（如空指针），或者段不允许这样访问：只结束该进程
+        if (!uva || vma_fault(current_proc, va, kind) < 0) {
+            printf("page fault: pid %d va=0x%lx sepc=0x%lx, killed\n",
+                   current_proc->pid, va, sepc);
+            exit_process(-1);
+        }
+    } else if (scause == 2 && cpu_probing == 1 && !user) {
+        // cpu_probe 试探的指令不存在：跳过它（探测用的都是 4 字节指令）
+        cpu_probing = 2;
+        tf->epc = sepc + 4;
+    } else if (user) {
+        // U 模式的其他异常（非法指令等）只结束该进程
+        printf("user trap: pid %d scause=0x%lx sepc=0x%lx, killed\n",
+               current_proc->pid, scause, sepc);
+        exit_process(-1);
     } else {
         printf("Unexpected trap: scause=0x%lx sepc=0x%lx\n", scause, sepc);
-        while(1);
+        panic("kerneltrap");
     }
+
+    w_sstatus(sstatus);
 }
 
 // 初始化中断系统
 void trap_init(void) {
     printf("trap_init: setting up interrupt handling...\n");
 
-    // 1. 委托时钟中断到 S 模式
-    w_mideleg(r_mideleg() | (1L << 5));  // bit 5 = supervisor timer interrupt
+    // 1. 委托时钟中断与外部中断到 S 模式
+    w_mideleg(r_mideleg() | (1L << 5) | (1L << 9));  // bit 5 = 时钟，bit 9 = 外部
 
-    // 2. 设置 S 模式中断向量
+    // 2. 设置 S 模式中断向量（sscratch = 0 表示当前在内核中）
     w_stvec((uint64_t)kernelvec);
+    asm volatile("csrw sscratch, zero");
+
+    // 允许内核在系统调用中直接访问用户页
+    w_sstatus(r_sstatus() | SSTATUS_SUM);
 
-    // 3. 开启 S 模式时钟中断
-    w_sie(r_sie() | (1L << 5));
+    // 3. 开启 S 模式时钟中断与外部中断（PLIC）
+    plic_init();
+    w_sie(r_sie() | (1L << 5) | (1L << 9));
 
     // 4. 全局开启中断（S 模式）
     w_sstatus(r_sstatus() | (1L << 1)); // SIE bit in sstatus
 
     // 5. 设置第一次时钟中断
-    sbi_set_timer(r_time() + 1000000);
+    next_tick = r_time() + TICK_INTERVAL;
+    sbi_set_timer(next_tick);
 
     printf("trap_init: interrupt system ready\n");
 }
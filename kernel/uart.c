@@ -1,27 +1,63 @@
-
 // kernel/uart.c
+// 16550 串口：发送 FIFO 16 字节，THR 空时可以连续写满而不必逐字节查询 LSR
+#include "riscv.h"
 #include "uart.h"
+#include "console.h"
+#include "trap/plic.h"
+#include "fdt.h"
 
-#define UART0_BASE 0x10000000L
-#define UART0_THR  (UART0_BASE + 0x00)
-#define UART0_LSR  (UART0_BASE + 0x05)
+// 寄存器基址来自设备树（fdt_init 在 uart_init 之前运行）
+#define UART0_THR  (machine.uart + 0x00)
+#define UART0_IER  (machine.uart + 0x01)
+#define UART0_IIR  (machine.uart + 0x02)   // 读：中断原因
+#define UART0_FCR  (machine.uart + 0x02)   // 写：FIFO 控制
+#define UART0_LSR  (machine.uart + 0x05)
+#define IER_THRI   (1 << 1)         // 发送保持寄存器空中断
+#define FCR_ENABLE (1 << 0)
+#define FCR_CLEAR  (3 << 1)         // 清空收发 FIFO
 #define LSR_THRE   (1 << 5)
 
-// 初始化UART（目前为空，以后可扩展）
+#define REG(r) (*(volatile uint8_t*)(r))
+
 void uart_init(void) {
-    // QEMU virt 平台无需初始化，硬件默认可用
+    REG(UART0_IER) = 0;
+    REG(UART0_FCR) = FCR_ENABLE | FCR_CLEAR;
+    plic_enable(machine.uart_irq);
+}
+
+// 发送 FIFO 已空：接下来可以直接写入 UART_FIFO 个字节
+int uart_tx_ready(void) {
+    return (REG(UART0_LSR) & LSR_THRE) != 0;
+}
+
+// 不检查 LSR 直接写 THR，调用者保证 FIFO 有空位
+void uart_tx(char c) {
+    REG(UART0_THR) = c;
 }
 
-// 发送一个字符
+// FIFO 排空时是否产生中断（由控制台 drainer 开关）
+void uart_tx_intr(int on) {
+    if (on) {
+        REG(UART0_IER) |= IER_THRI;
+    } else {
+        REG(UART0_IER) &= ~IER_THRI;
+    }
+}
+
+// 同步发送一个字符（panic 路径使用，不经过控制台环）
 void uart_putc(char c) {
-    // 等待发送缓冲区空
-    while ((*(volatile char*)UART0_LSR & LSR_THRE) == 0)
+    while (!uart_tx_ready())
         ;
-    // 发送字符
-    *(volatile char*)UART0_THR = c;
+    uart_tx(c);
 
     // 处理换行：输出 \n 时自动补 \r
     if (c == '\n') {
         uart_putc('\r');
     }
 }
+
+// 读 IIR 清除中断，然后继续排空控制台环
+void uart_intr(void) {
+    (void)REG(UART0_IIR);
+    console_drain();
+}
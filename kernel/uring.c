@@ -0,0 +1,108 @@
+// kernel/uring.c
+// 共享提交/完成环：一次 ring_enter 执行多个文件操作，减少 trap 次数
+#include "riscv.h"
+#include "uring.h"
+#include "syscall.h"
+#include "string.h"
+#include "printf.h"
+#include "mm/pmm.h"
+#include "mm/vm.h"
+#include "proc/proc.h"
+
+// 为进程分配环页；用户进程同时把它映射到 URING_VA
+struct uring* uring_setup(struct proc *p) {
+    if (p->uring) {
+        return p->uring;
+    }
+
+    struct uring *r = alloc_page();
+    if (r == 0) {
+        return 0;
+    }
+    page_zero(r);
+
+    if (p->pagetable) {
+        if (map_page(p->pagetable, URING_VA, (uint64_t)r, PTE_R | PTE_W | PTE_U) < 0) {
+            free_page(r);
+            return 0;
+        }
+    }
+    p->uring = r;
+    return r;
+}
+
+// 进程回收时释放（用户页表中的映射随 uvmfree 一起释放）
+void uring_free(struct proc *p) {
+    if (p->uring && p->pagetable == 0) {
+        free_page(p->uring);
+    }
+    p->uring = 0;
+}
+
+// 从用户地址复制以 '\0' 结尾的路径，不能读出用户地址空间
+static int fetchstr(uint64_t addr, char *buf, int max) {
+    const char *s = (const char*)addr;
+    if (addr == 0) return -1;
+    for (int i = 0; i < max; i++) {
+        if (!user_range_ok(addr + i, 1)) return -1;
+        buf[i] = s[i];
+        if (buf[i] == '\0') return i;
+    }
+    return -1;  // 过长
+}
+
+static int uring_exec_sqe(struct uring_sqe *sqe) {
+    char path[64];
+
+    switch (sqe->opcode) {
+    case URING_OP_NOP:
+        return 0;
+    case URING_OP_OPEN:
+        if (fetchstr(sqe->addr, path, sizeof(path)) < 0) return -1;
+        return file_open(path, sqe->len);
+    case URING_OP_CLOSE:
+        return file_close(sqe->fd);
+    case URING_OP_READ:
+        return file_read(sqe->fd, (void*)sqe->addr, sqe->len);
+    case URING_OP_WRITE:
+        return file_write(sqe->fd, (const void*)sqe->addr, sqe->len);
+    case URING_OP_UNLINK:
+        if (fetchstr(sqe->addr, path, sizeof(path)) < 0) return -1;
+        return file_unlink(path);
+    default:
+        return -1;
+    }
+}
+
+// 依次执行最多 to_submit 个 SQE，每个产生一个 CQE
+// CQ 满时停止，返回实际消费的 SQE 数
+int uring_enter(struct proc *p, int to_submit) {
+    struct uring *r = p->uring;
+    if (r == 0 || to_submit < 0) {
+        return -1;
+    }
+
+    uint32_t head = r->sq_head;
+    uint32_t tail = __atomic_load_n(&r->sq_tail, __ATOMIC_ACQUIRE);
+    int done = 0;
+
+    while (head != tail && done < to_submit) {
+        uint32_t cq_tail = r->cq_tail;
+        if (cq_tail - __atomic_load_n(&r->cq_head, __ATOMIC_ACQUIRE) >= URING_CQ_ENTRIES) {
+            break;  // 完成队列已满，等用户消费
+        }
+
+        // 先把 SQE 复制出来，防止用户在执行过程中修改
+        struct uring_sqe sqe = r->sq[head & (URING_SQ_ENTRIES - 1)];
+        head++;
+        __atomic_store_n(&r->sq_head, head, __ATOMIC_RELEASE);
+
+        struct uring_cqe *cqe = &r->cq[cq_tail & (URING_CQ_ENTRIES - 1)];
+        cqe->user_data = sqe.user_data;
+        cqe->res = uring_exec_sqe(&sqe);
+        cqe->flags = 0;
+        __atomic_store_n(&r->cq_tail, cq_tail + 1, __ATOMIC_RELEASE);
+        done++;
+    }
+    return done;
+}
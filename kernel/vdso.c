@@ -0,0 +1,56 @@
+// kernel/vdso.c
+// vDSO 数据页：getpid 与时钟读取不再需要 ecall
+#include "riscv.h"
+#include "printf.h"
+#include "string.h"
+#include "vdso.h"
+#include "mm/pmm.h"
+#include "mm/vm.h"
+#include "trap/trap.h"
+
+static struct vdso_data *vdso;
+
+void vdso_init(void) {
+    vdso = alloc_page();
+    if (vdso == 0) {
+        printf("vdso_init: out of memory\n");
+        return;
+    }
+    page_zero(vdso);
+    vdso->timebase_freq = TIMEBASE_FREQ;
+    vdso->tick_interval = TICK_INTERVAL;
+    vdso->boot_time = r_time();
+
+    // 内核任务运行在内核页表上，同样可以通过 VDSO_VA 读取
+    if (vdso_map(kernel_pagetable) < 0) {
+        printf("vdso_init: failed to map vdso page\n");
+        return;
+    }
+    printf("vdso_init: data page at 0x%lx\n", VDSO_VA);
+}
+
+// 以只读方式映射到 pt；PTE_SHARED 使 uvmfree 不释放该页
+int vdso_map(pagetable_t pt) {
+    if (vdso == 0) return -1;
+    int perm = PTE_R | PTE_SHARED;
+    if (pt != kernel_pagetable) {
+        perm |= PTE_U;
+    }
+    return map_page(pt, VDSO_VA, (uint64_t)vdso, perm);
+}
+
+// 时钟中断中调用
+void vdso_tick(void) {
+    if (vdso == 0) return;
+    vdso->seq++;
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    vdso->ticks++;
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    vdso->seq++;
+}
+
+// 调度器切换进程时调用
+void vdso_set_pid(int pid) {
+    if (vdso == 0) return;
+    vdso->pid = pid;
+}
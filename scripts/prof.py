@@ -0,0 +1,107 @@
+#!/usr/bin/env python3
+# scripts/prof.py
+# 符号化 kernel/prof.c 输出的采样结果（prof: begin ... prof: end），得到平面 profile 与 folded stacks
+#
+#   make run BOOTARGS="prof=1000 prof_secs=5" | tee run.log
+#   scripts/prof.py kernel.elf run.log                   # 平面 profile
+#   scripts/prof.py kernel.elf run.log --folded out.folded
+#   flamegraph.pl out.folded > prof.svg                   # https://github.com/brendangregg/FlameGraph
+#
+# 符号表来自 nm（默认 riscv64-linux-gnu-nm，找不到时用 nm，可用 --nm 或环境变量 NM 指定）
+import argparse
+import bisect
+import os
+import shutil
+import subprocess
+import sys
+
+
+def load_symbols(elf, nm):
+    out = subprocess.run([nm, "-n", "--defined-only", elf],
+                         check=True, capture_output=True, text=True).stdout
+    addrs, names = [], []
+    for line in out.splitlines():
+        parts = line.split()
+        if len(parts) != 3 or parts[1] not in "tTwW":
+            continue
+        addrs.append(int(parts[0], 16))
+        names.append(parts[2])
+    return addrs, names
+
+
+def symbolize(addrs, names, pc):
+    i = bisect.bisect_right(addrs, pc) - 1
+    return names[i] if i >= 0 else "0x%x" % pc
+
+
+def parse_dump(lines):
+    """返回最后一次 dump 的 (头部字段, [(count, pid, user, [pc...])])"""
+    dumps, cur, header = [], None, None
+    for line in lines:
+        line = line.strip()
+        idx = line.find("prof: ")
+        if idx < 0:
+            continue
+        body = line[idx + len("prof: "):]
+        if body.startswith("begin"):
+            header = dict(kv.split("=", 1) for kv in body.split()[1:] if "=" in kv)
+            cur = []
+        elif body == "end" and cur is not None:
+            dumps.append((header, cur))
+            cur = None
+        elif cur is not None:
+            f = body.split()
+            if len(f) < 4 or f[2] not in ("k", "u"):
+                continue
+            cur.append((int(f[0]), int(f[1]), f[2] == "u", [int(x, 16) for x in f[3:]]))
+    if not dumps:
+        sys.exit("prof.py: no complete 'prof: begin ... prof: end' block in input")
+    return dumps[-1]
+
+
+def main():
+    ap = argparse.ArgumentParser(description="symbolize minios profiler output")
+    ap.add_argument("elf", help="kernel.elf (or kernel-bench.elf) that produced the samples")
+    ap.add_argument("log", nargs="?", help="console log (default: stdin)")
+    ap.add_argument("--nm", default=os.environ.get("NM"), help="nm binary")
+    ap.add_argument("--folded", metavar="FILE", help="write folded stacks for flamegraph.pl")
+    ap.add_argument("--top", type=int, default=30, help="rows in the flat profile")
+    args = ap.parse_args()
+
+    nm = args.nm or shutil.which("riscv64-linux-gnu-nm") or "nm"
+    addrs, names = load_symbols(args.elf, nm)
+    with (open(args.log, errors="replace") if args.log else sys.stdin) as f:
+        header, stacks = parse_dump(f)
+
+    total = sum(s[0] for s in stacks)
+    if total == 0:
+        sys.exit("prof.py: dump contains no samples")
+    self_cnt, incl_cnt, folded = {}, {}, {}
+    for count, pid, user, pcs in stacks:
+        if user:
+            frames = ["[user]"]
+        else:
+            # pcs[0] 是被打断的 pc，其余是返回地址：减 1 落在 call 指令上
+            frames = [symbolize(addrs, names, pc if i == 0 else pc - 1) for i, pc in enumerate(pcs)]
+        self_cnt[frames[0]] = self_cnt.get(frames[0], 0) + count
+        for fn in set(frames):
+            incl_cnt[fn] = incl_cnt.get(fn, 0) + count
+        key = ";".join(["pid %d" % pid if pid else "scheduler"] + frames[::-1])
+        folded[key] = folded.get(key, 0) + count
+
+    print("# %d samples at %s Hz, %s distinct stacks, %s dropped" %
+          (total, header.get("hz", "?"), header.get("stacks", "?"), header.get("dropped", "?")))
+    print("%8s %7s %8s %7s  %s" % ("self", "self%", "total", "total%", "function"))
+    rows = sorted(incl_cnt, key=lambda fn: (-self_cnt.get(fn, 0), -incl_cnt[fn], fn))
+    for fn in rows[:args.top]:
+        n, t = self_cnt.get(fn, 0), incl_cnt[fn]
+        print("%8d %6.2f%% %8d %6.2f%%  %s" % (n, 100.0 * n / total, t, 100.0 * t / total, fn))
+
+    if args.folded:
+        with open(args.folded, "w") as out:
+            for key, n in sorted(folded.items()):
+                out.write("%s %d\n" % (key, n))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,15 @@
+// user/hello.c
+// 打印命令行参数
+#include "user.h"
+
+int main(int argc, char **argv) {
+    puts("hello: pid ");
+    putint(getpid());
+    puts(", argv:");
+    for (int i = 0; i < argc; i++) {
+        puts(" ");
+        puts(argv[i]);
+    }
+    puts("\n");
+    return 0;
+}
@@ -0,0 +1,21 @@
+// user/lazy.c
+// 大数组在 .bss 中不占文件空间；exec 懒加载，只有访问到的页才会被分配
+#include "user.h"
+
+#define BIG_SIZE (256 * 1024)
+
+static char big[BIG_SIZE];
+
+int main(int argc, char **argv) {
+    int touched = 0;
+    for (int off = 0; off < BIG_SIZE; off += 64 * 1024) {
+        big[off] = 1;
+        touched++;
+    }
+    puts("lazy: touched ");
+    putint(touched);
+    puts(" of ");
+    putint(BIG_SIZE / 4096);
+    puts(" bss pages\n");
+    return big[0] - 1;
+}
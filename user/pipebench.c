@@ -0,0 +1,91 @@
+// user/pipebench.c
+// 管道吞吐：pipebench w|r <读端 fd> <写端 fd>
+// 写者对每种消息大小写 1MB，读者用同样大小读并计时、校验数据
+// 页对齐的整页消息经页移交传给读者，不复制
+#include "user.h"
+#include "vdso.h"
+
+#define TOTAL (1 << 20)
+
+static const int sizes[] = { 64, 512, 4096, 65536 };
+static char buf[65536] __attribute__((aligned(4096)));
+
+static int atoi(const char *s) {
+    int n = 0;
+    while (*s >= '0' && *s <= '9') {
+        n = n * 10 + *s++ - '0';
+    }
+    return n;
+}
+
+static int writer(int wfd) {
+    for (int i = 0; i < sizeof(buf); i++) {
+        buf[i] = i % 64;
+    }
+    for (int s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        for (int off = 0; off < TOTAL; off += sizes[s]) {
+            if (write(wfd, buf, sizes[s]) != sizes[s]) {
+                puts("pipebench: write failed\n");
+                return 1;
+            }
+        }
+    }
+    close(wfd);
+    return 0;
+}
+
+static int reader(int rfd) {
+    int bad = 0;
+
+    memset(buf, 0, sizeof(buf));  // 先映射好缓冲区，整页消息才能直接换页
+    for (int s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        int size = sizes[s];
+        int got = 0;
+        uint64_t t0 = vdso_clock_ns();
+        while (got < TOTAL) {
+            int want = TOTAL - got < size ? TOTAL - got : size;
+            int n = read(rfd, buf, want);
+            if (n <= 0) {
+                puts("pipebench: unexpected EOF\n");
+                return 1;
+            }
+            if (buf[0] != got % 64 || buf[n - 1] != (got + n - 1) % 64) {
+                bad++;
+            }
+            got += n;
+        }
+        uint64_t ns = vdso_clock_ns() - t0;
+
+        puts("pipebench: ");
+        putint(size);
+        puts("-byte messages: ");
+        putint(ns ? (int)((uint64_t)TOTAL * 1000 / ns) : 0);
+        puts(" MB/s\n");
+    }
+    if (read(rfd, buf, 1) != 0) {
+        puts("pipebench: missing EOF\n");
+        return 1;
+    }
+    if (bad) {
+        puts("pipebench: data mismatch in ");
+        putint(bad);
+        puts(" reads\n");
+    }
+    return bad != 0;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 4) {
+        puts("usage: pipebench w|r rfd wfd\n");
+        return 1;
+    }
+    int rfd = atoi(argv[2]);
+    int wfd = atoi(argv[3]);
+
+    if (argv[1][0] == 'w') {
+        close(rfd);
+        return writer(wfd);
+    }
+    close(wfd);
+    return reader(rfd);
+}
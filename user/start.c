@@ -0,0 +1,26 @@
+// user/start.c
+// 独立用户程序的入口：exec 把 argc/argv 放在 a0/a1
+#include "user.h"
+
+__attribute__((section(".text.start")))
+void _start(int argc, char **argv) {
+    exit(main(argc, argv));
+}
+
+int puts(const char *s) {
+    return write(1, s, strlen(s));
+}
+
+int putint(int n) {
+    char buf[16];
+    int i = sizeof(buf);
+    unsigned int x = n < 0 ? -n : n;
+
+    do {
+        buf[--i] = '0' + x % 10;
+    } while ((x /= 10) != 0);
+    if (n < 0) {
+        buf[--i] = '-';
+    }
+    return write(1, buf + i, sizeof(buf) - i);
+}
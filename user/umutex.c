@@ -0,0 +1,63 @@
+// user/umutex.c
+// 基于 futex 的用户态互斥锁与线程辅助函数
+// 无竞争时加锁/解锁只是一条原子指令，不会 ecall
+#include "proc/proc.h"
+
+void umutex_init(struct umutex *m) {
+    __atomic_store_n(&m->state, 0, __ATOMIC_RELEASE);
+}
+
+void umutex_lock(struct umutex *m) {
+    int c = 0;
+
+    // 快路径：0 -> 1
+    if (__atomic_compare_exchange_n(&m->state, &c, 1, 0,
+                                    __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+        return;
+    }
+
+    // 慢路径：标记为“有等待者”(2) 后在 futex 上睡眠
+    if (c != 2) {
+        c = __atomic_exchange_n(&m->state, 2, __ATOMIC_ACQUIRE);
+    }
+    while (c != 0) {
+        futex(&m->state, FUTEX_WAIT, 2);
+        c = __atomic_exchange_n(&m->state, 2, __ATOMIC_ACQUIRE);
+    }
+}
+
+void umutex_unlock(struct umutex *m) {
+    // 1 -> 0 说明没有等待者，直接返回
+    if (__atomic_fetch_sub(&m->state, 1, __ATOMIC_RELEASE) != 1) {
+        __atomic_store_n(&m->state, 0, __ATOMIC_RELEASE);
+        futex(&m->state, FUTEX_WAKE, 1);
+    }
+}
+
+// 线程入口参数放在新栈顶，线程函数返回后由 trampoline 调用 exit
+struct thread_start {
+    void (*fn)(void *);
+    void *arg;
+};
+
+static void thread_trampoline(void *p) {
+    struct thread_start *ts = p;
+    ts->fn(ts->arg);
+    exit(0);
+}
+
+// 在 stack（栈顶地址）上启动线程，tid 在线程退出时由内核清零
+int thread_create(void (*fn)(void *), void *arg, void *stack, int *tid) {
+    struct thread_start *ts = (struct thread_start*)((uint64_t)stack & ~0xFUL) - 1;
+    ts->fn = fn;
+    ts->arg = arg;
+    return clone(thread_trampoline, ts, ts, tid);
+}
+
+// 等待 tid 被内核清零（线程已退出）
+void thread_join(int *tid) {
+    int t;
+    while ((t = __atomic_load_n(tid, __ATOMIC_ACQUIRE)) != 0) {
+        futex(tid, FUTEX_WAIT, t);
+    }
+}
@@ -0,0 +1,15 @@
+// user/user.h
+// 独立用户程序（user/_*）使用的接口
+#ifndef __USER_H__
+#define __USER_H__
+
+#include "proc/proc.h"   // 系统调用桩函数声明
+#include "string.h"
+
+int main(int argc, char **argv);
+
+// user/start.c
+int puts(const char *s);
+int putint(int n);
+
+#endif